@@ -0,0 +1,57 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+namespace {
+
+std::atomic<std::size_t> allocationCount{0};
+std::atomic<std::size_t> allocatedBytes{0};
+std::atomic<std::size_t> lazyGrowthCount{0};
+
+void count(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (allocation_counter::LazyGrowthScope::isActive()) {
+        lazyGrowthCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void* countedAllocate(std::size_t size) {
+    count(size);
+    if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* countedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    count(size);
+    const auto align = static_cast<std::size_t>(alignment);
+    const std::size_t rounded = ((size ? size : 1) + align - 1) / align * align;
+    if (void* pointer = std::aligned_alloc(align, rounded)) return pointer;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+namespace allocation_counter {
+
+std::size_t getAllocationCount() { return allocationCount.load(std::memory_order_relaxed); }
+std::size_t getAllocatedBytes() { return allocatedBytes.load(std::memory_order_relaxed); }
+std::size_t getLazyGrowthCount() { return lazyGrowthCount.load(std::memory_order_relaxed); }
+
+} // namespace allocation_counter
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Counts global operator new calls made by the linking executable
+ *
+ * Linking AllocationCounter.cpp replaces the global allocation functions,
+ * so only tools that want the numbers (ants_headless) pay for the counter.
+ */
+namespace allocation_counter {
+
+std::size_t getAllocationCount();
+std::size_t getAllocatedBytes();
+// The part of getAllocationCount() made inside a LazyGrowthScope.
+std::size_t getLazyGrowthCount();
+
+/**
+ * @brief Marks allocations that grow storage with the explored area
+ *
+ * Tile chunks, pheromone blocks and the tables indexing them are allocated
+ * the first time ants reach a new part of the world, however long the run
+ * has been going. While a scope is alive on a thread, that thread's
+ * allocations are also counted by getLazyGrowthCount(), so tools can tell
+ * them apart from allocations a tick should never make.
+ *
+ * Header-only, so the simulation core can mark its growth paths without
+ * linking the counter; without it the scope does nothing.
+ */
+class LazyGrowthScope {
+public:
+    LazyGrowthScope() { ++depth(); }
+    ~LazyGrowthScope() { --depth(); }
+    LazyGrowthScope(const LazyGrowthScope&) = delete;
+    LazyGrowthScope& operator=(const LazyGrowthScope&) = delete;
+
+    static bool isActive() { return depth() > 0; }
+
+private:
+    static unsigned int& depth() {
+        static thread_local unsigned int value = 0;
+        return value;
+    }
+};
+
+} // namespace allocation_counter
@@ -1,15 +1,14 @@
 #pragma once
 
-#include <memory>
+#include <cstddef>
 #include <optional>
-#include <random>
-#include <unordered_map>
 
-#include <SFML/Graphics/Color.hpp>
 #include "Position.h"
 
-class MovementStrategy;
+class AntStore;
+class MovementActions;
 class World;
+struct SensoryInput;
 
 enum class ItemType {
     FOOD,
@@ -17,6 +16,8 @@ enum class ItemType {
     EGG,
 };
 
+constexpr std::size_t kItemTypeCount = 3;
+
 enum class AntRole {
     QUEEN,
     WORKER,
@@ -26,32 +27,37 @@ enum class AntRole {
     NURSE
 };
 
-class Ant {
-private:
-    std::mt19937& rng;
-    int id;
-    AntRole role;
+constexpr std::size_t kAntRoleCount = 6;
+
+struct AntRoleConfig {
     float size;
-    sf::Color color;
     float movementSpeed;
     float maxLoad;
-    std::unique_ptr<FloatPosition> position;
-    std::unique_ptr<FloatPosition> previousPosition;
-    std::unique_ptr<MovementStrategy> movementStrategy;
-    Vector2D lastDirection;
-    float initialWanderRandomness{0.8f};
-    float wanderRandomness{initialWanderRandomness};
-    std::unordered_map<ItemType, float> carriedItems;
-    std::optional<FloatPosition> destination;
-    bool hasReachedDestination = false;
+};
+
+AntRoleConfig configForRole(AntRole role);
+
+// Lower-case name of the role, for reports.
+const char* roleName(AntRole role);
+
+/**
+ * @brief Lightweight handle to one ant living in an AntStore
+ *
+ * The handle holds no state of its own; it is two words and can be freely
+ * copied. It stays valid as long as the store is not reallocated.
+ */
+class Ant {
+private:
+    AntStore* store;
+    std::size_t index;
 
 public:
-    Ant(AntRole role, int id, std::mt19937& rng);
-    ~Ant();
+    Ant(AntStore& store, std::size_t index) : store(&store), index(index) {}
 
+    std::size_t getIndex() const { return index; }
+    int getId() const;
     AntRole getRole() const;
     float getSize() const;
-    sf::Color getColor() const;
     FloatPosition getPosition() const;
     void setPosition(FloatPosition newPosition);
     Vector2D getLastDirection() const;
@@ -61,7 +67,17 @@ public:
     float getMaxLoad() const;
     void setDestination(const FloatPosition& dest);
 
+    // Full one-ant step: sense, decide (static dispatch on role), apply
+    // actions, advance.
     void update(World& world);
+    // The stages of update(), for callers that run each stage over a batch.
+    SensoryInput sense(World& world) const;
+    // As sense(), with the distance to the nest already computed, e.g. for a
+    // whole batch at once.
+    SensoryInput sense(World& world, float distanceToNest) const;
+    void applyActions(const MovementActions& actions);
+    // Moves along `direction` and remembers it as the last direction.
+    void advance(const Vector2D& direction, World& world);
     void move(const Vector2D& direction, World& world);
     bool pickUpItem(ItemType itemType, float amount);
     void dropItem(std::optional<ItemType> itemType = std::nullopt);
@@ -0,0 +1,82 @@
+#include "AntStore.h"
+
+namespace {
+
+template<typename T>
+void applyOrder(std::vector<T>& values, const std::vector<std::size_t>& order) {
+    std::vector<T> reordered;
+    reordered.reserve(values.size());
+    for (const std::size_t index : order) {
+        reordered.push_back(values[index]);
+    }
+    values = std::move(reordered);
+}
+
+} // namespace
+
+std::size_t AntStore::add(int id, AntRole role, const FloatPosition& position, CounterRng rng) {
+    const auto config = configForRole(role);
+    ids.push_back(id);
+    roles.push_back(role);
+    positions.push_back(position);
+    previousPositions.push_back(position);
+    lastDirections.emplace_back(0.0f, 0.0f);
+    movementSpeeds.push_back(config.movementSpeed);
+    maxLoads.push_back(config.maxLoad);
+    wanderRandomness.push_back(kInitialWanderRandomness);
+    carriedItems.push_back({});
+    destinations.push_back(position);
+    headingToDestination.push_back(0);
+    rngs.push_back(rng);
+    pendingPheromones.push_back({});
+    groupedByRole = false;
+    return ids.size() - 1;
+}
+
+void AntStore::groupByRole() {
+    // Stable counting sort on role, so ants keep their relative order.
+    std::array<std::size_t, kAntRoleCount + 1> offsets{};
+    for (const AntRole role : roles) {
+        ++offsets[static_cast<std::size_t>(role) + 1];
+    }
+    for (std::size_t r = 1; r < offsets.size(); ++r) {
+        offsets[r] += offsets[r - 1];
+    }
+    roleOffsets = offsets;
+
+    std::vector<std::size_t> order(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+        order[offsets[static_cast<std::size_t>(roles[i])]++] = i;
+    }
+
+    applyOrder(ids, order);
+    applyOrder(roles, order);
+    applyOrder(positions, order);
+    applyOrder(previousPositions, order);
+    applyOrder(lastDirections, order);
+    applyOrder(movementSpeeds, order);
+    applyOrder(maxLoads, order);
+    applyOrder(wanderRandomness, order);
+    applyOrder(carriedItems, order);
+    applyOrder(destinations, order);
+    applyOrder(headingToDestination, order);
+    applyOrder(rngs, order);
+    applyOrder(pendingPheromones, order);
+    groupedByRole = true;
+}
+
+void AntStore::reserve(std::size_t count) {
+    ids.reserve(count);
+    roles.reserve(count);
+    positions.reserve(count);
+    previousPositions.reserve(count);
+    lastDirections.reserve(count);
+    movementSpeeds.reserve(count);
+    maxLoads.reserve(count);
+    wanderRandomness.reserve(count);
+    carriedItems.reserve(count);
+    destinations.reserve(count);
+    headingToDestination.reserve(count);
+    rngs.reserve(count);
+    pendingPheromones.reserve(count);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "Ant.h"
+#include "Pheromone.h"
+#include "Position.h"
+#include "Random.h"
+#include "Vector2D.h"
+
+/**
+ * @brief Structure-of-arrays storage for every ant in the world
+ *
+ * Index i in each array describes the same ant. Per-tick updates only write
+ * into these arrays in place, so stepping the colony never allocates.
+ *
+ * groupByRole() reorders the ants so each role occupies one contiguous
+ * index range, which lets role-specific kernels stream over plain arrays.
+ * Adding an ant clears the grouping until the next groupByRole(); indices
+ * (and Ant handles) are only stable between regroupings.
+ */
+class AntStore {
+public:
+    static constexpr float kInitialWanderRandomness = 0.8f;
+
+    std::vector<int> ids;
+    std::vector<AntRole> roles;
+    std::vector<FloatPosition> positions;
+    std::vector<FloatPosition> previousPositions;
+    std::vector<Vector2D> lastDirections;
+    std::vector<float> movementSpeeds;
+    std::vector<float> maxLoads;
+    std::vector<float> wanderRandomness;
+    std::vector<std::array<float, kItemTypeCount>> carriedItems;
+    std::vector<FloatPosition> destinations;
+    std::vector<std::uint8_t> headingToDestination;
+    std::vector<CounterRng> rngs;
+    // Pheromone laid this tick on the tile the ant started from. Applied by
+    // World after every ant has moved, so ants never observe each other's
+    // deposits mid-tick regardless of update order or thread count.
+    std::vector<std::array<float, kPheromoneTypeCount>> pendingPheromones;
+
+private:
+    bool groupedByRole = true;
+    std::array<std::size_t, kAntRoleCount + 1> roleOffsets{};
+
+public:
+    class Iterator {
+    private:
+        AntStore* store;
+        std::size_t index;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Ant;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator(AntStore* store, std::size_t index) : store(store), index(index) {}
+        Ant operator*() const { return Ant(*store, index); }
+        Iterator& operator++() { ++index; return *this; }
+        bool operator==(const Iterator& other) const { return index == other.index; }
+    };
+
+    std::size_t add(int id, AntRole role, const FloatPosition& position, CounterRng rng);
+    void reserve(std::size_t count);
+
+    void groupByRole();
+    bool isGroupedByRole() const { return groupedByRole; }
+    // Index range [first, second) of `role`; only meaningful while grouped.
+    std::pair<std::size_t, std::size_t> roleRange(AntRole role) const {
+        const auto r = static_cast<std::size_t>(role);
+        return { roleOffsets[r], roleOffsets[r + 1] };
+    }
+
+    std::size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    Ant operator[](std::size_t index) { return Ant(*this, index); }
+
+    Iterator begin() { return Iterator(this, 0); }
+    Iterator end() { return Iterator(this, size()); }
+};
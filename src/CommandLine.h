@@ -0,0 +1,37 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace command_line {
+
+/**
+ * @brief Parses an option value that must be a number and nothing else
+ *
+ * Integers are decimal and must fit in T, so a negative value or one too
+ * large for the option is rejected instead of wrapping around. Floating
+ * values must be finite. Leading whitespace, a sign on an unsigned value and
+ * trailing characters ("1e6" for an integer, "5s") all fail, so a typo is
+ * reported rather than read as a different number.
+ *
+ * Shared by the command-line drivers; header-only so it adds no sources to
+ * the simulation core.
+ */
+template <typename T>
+std::optional<T> parseNumber(std::string_view text) {
+    static_assert(std::is_arithmetic_v<T>);
+    T value{};
+    const char* end = text.data() + text.size();
+    const auto [rest, error] = std::from_chars(text.data(), end, value);
+    if (text.empty() || error != std::errc() || rest != end) return std::nullopt;
+    if constexpr (std::is_floating_point_v<T>) {
+        if (!std::isfinite(value)) return std::nullopt;
+    }
+    return value;
+}
+
+} // namespace command_line
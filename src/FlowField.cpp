@@ -0,0 +1,240 @@
+#include <algorithm>
+
+#include "FlowField.h"
+
+FlowField::FlowField(unsigned int worldWidth, unsigned int worldHeight)
+    : worldWidth(worldWidth), worldHeight(worldHeight) {
+}
+
+std::uint8_t FlowField::terrainCost(TerrainType terrain) {
+    switch (terrain) {
+        case TerrainType::SOIL:
+        case TerrainType::GRASS: return 1;
+        case TerrainType::SAND:  return kMaxTerrainCost;
+        case TerrainType::ROCK:  return 0;
+    }
+    return 1;
+}
+
+std::size_t FlowField::neighbor(std::size_t tile, unsigned int step) const {
+    // Unsigned wrap-around puts steps off the left or top edge out of range.
+    const unsigned int column = static_cast<unsigned int>(tile % columns) + kStepX[step];
+    const unsigned int row = static_cast<unsigned int>(tile / columns) + kStepY[step];
+    return column < columns && row < rows ? static_cast<std::size_t>(row) * columns + column : kOutside;
+}
+
+template <typename Fn>
+void FlowField::forEachNeighbor(std::size_t tile, Fn&& fn) const {
+    // One division per tile rather than one per neighbour.
+    const auto column = static_cast<unsigned int>(tile % columns);
+    const auto row = static_cast<unsigned int>(tile / columns);
+    for (unsigned int step = 0; step < 8; ++step) {
+        const unsigned int x = column + kStepX[step];
+        const unsigned int y = row + kStepY[step];
+        if (x >= columns || y >= rows) continue;
+        // A diagonal step may not squeeze past a corner of impassable terrain.
+        if (step >= 4 && (terrainCosts[static_cast<std::size_t>(row) * columns + x] == 0 ||
+                          terrainCosts[static_cast<std::size_t>(y) * columns + column] == 0)) {
+            continue;
+        }
+        fn(step, static_cast<std::size_t>(y) * columns + x);
+    }
+}
+
+bool FlowField::update(const IntegerPosition& newTarget, const TerrainLookup& terrainAt) {
+    if (!built || !(newTarget == target)) {
+        build(newTarget, terrainAt);
+        return true;
+    }
+    if (changedTiles.empty()) return false;
+    repair(terrainAt);
+    return true;
+}
+
+void FlowField::markChanged(const IntegerPosition& pos) {
+    if (!built) return;
+    const std::size_t tile = indexOf(pos.getIntX(), pos.getIntY());
+    if (tile != kOutside) {
+        changedTiles.push_back(static_cast<std::uint32_t>(tile));
+    }
+}
+
+void FlowField::touch(std::size_t tile) {
+    if (!marks[tile]) {
+        marks[tile] = 1;
+        touched.push_back(static_cast<std::uint32_t>(tile));
+    }
+}
+
+void FlowField::seed(std::uint32_t cost, std::size_t tile) {
+    costs[tile] = cost;
+    seeds.push_back({ cost, static_cast<std::uint32_t>(tile) });
+    touch(tile);
+}
+
+void FlowField::push(std::uint32_t cost, std::size_t tile) {
+    costs[tile] = cost;
+    buckets[cost % kBucketCount].push_back(static_cast<std::uint32_t>(tile));
+    ++queuedCount;
+    touch(tile);
+}
+
+void FlowField::propagate() {
+    // A tile's cost is settled when its bucket comes up; entries left behind
+    // by a later, cheaper push no longer match the tile's cost and are
+    // skipped. Seeds join the ring when the settled cost reaches theirs.
+    std::sort(seeds.begin(), seeds.end(), [](const Seed& a, const Seed& b) { return a.cost < b.cost; });
+    std::size_t nextSeed = 0;
+    std::uint32_t current = 0;
+    while (queuedCount > 0 || nextSeed < seeds.size()) {
+        if (queuedCount == 0) {
+            current = seeds[nextSeed].cost;
+        }
+        auto& bucket = buckets[current % kBucketCount];
+        for (; nextSeed < seeds.size() && seeds[nextSeed].cost == current; ++nextSeed) {
+            bucket.push_back(seeds[nextSeed].tile);
+            ++queuedCount;
+        }
+        while (!bucket.empty()) {
+            const std::uint32_t tile = bucket.back();
+            bucket.pop_back();
+            --queuedCount;
+            if (costs[tile] != current) continue;
+
+            forEachNeighbor(tile, [&](unsigned int step, std::size_t from) {
+                if (from == targetTile || terrainCosts[from] == 0) return;
+                // The step back from `from` is straight or diagonal just like this one.
+                const std::uint32_t cost = current + stepCost(from, step);
+                if (cost < costs[from]) {
+                    push(cost, from);
+                }
+            });
+        }
+        ++current;
+    }
+    seeds.clear();
+}
+
+void FlowField::updateDirection(std::size_t tile) {
+    std::uint8_t best = kNoDirection;
+    if (tile != targetTile && costs[tile] != kUnreachable) {
+        // First step in kStepX/kStepY order among the cheapest, so the
+        // direction only depends on the costs.
+        std::uint32_t bestCost = kUnreachable;
+        forEachNeighbor(tile, [&](unsigned int step, std::size_t to) {
+            if (costs[to] == kUnreachable) return;
+            const std::uint32_t cost = costs[to] + stepCost(tile, step);
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = static_cast<std::uint8_t>(step);
+            }
+        });
+    }
+    directions[tile] = best;
+}
+
+void FlowField::build(const IntegerPosition& newTarget, const TerrainLookup& terrainAt) {
+    target = newTarget;
+    const unsigned int tx = target.getIntX();
+    const unsigned int ty = target.getIntY();
+    originX = tx > kRadius ? tx - kRadius : 0;
+    originY = ty > kRadius ? ty - kRadius : 0;
+    columns = std::min(worldWidth, tx + kRadius + 1) - originX;
+    rows = std::min(worldHeight, ty + kRadius + 1) - originY;
+    targetTile = indexOf(tx, ty);
+
+    const std::size_t area = static_cast<std::size_t>(columns) * rows;
+    costs.assign(area, kUnreachable);
+    directions.assign(area, kNoDirection);
+    terrainCosts.resize(area);
+    marks.assign(area, 0);
+    for (unsigned int row = 0; row < rows; ++row) {
+        for (unsigned int column = 0; column < columns; ++column) {
+            terrainCosts[static_cast<std::size_t>(row) * columns + column] =
+                terrainCost(terrainAt(originX + column, originY + row));
+        }
+    }
+    changedTiles.clear();
+    touched.clear();
+
+    seed(0, targetTile);
+    propagate();
+    for (std::size_t tile = 0; tile < area; ++tile) {
+        updateDirection(tile);
+    }
+    for (const std::uint32_t tile : touched) {
+        marks[tile] = 0;
+    }
+    lastUpdatedTileCount = touched.size();
+    built = true;
+}
+
+void FlowField::repair(const TerrainLookup& terrainAt) {
+    // A changed tile can only raise the cost of tiles whose path leads
+    // through it or diagonally past it, and every diagonal step past it runs
+    // between two of its neighbours. Those tiles and the ones whose path
+    // leads through them are reset and re-seeded from their neighbours;
+    // Dijkstra from there settles them and lowers any tile that now has a
+    // cheaper path. Costs of all other tiles stay valid upper bounds, so
+    // the result is the exact cheapest cost everywhere.
+    touched.clear();
+    for (const std::uint32_t tile : changedTiles) {
+        terrainCosts[tile] = terrainCost(terrainAt(originX + tile % columns, originY + tile / columns));
+    }
+    // Neighbours are read unfiltered here: a step past a changed tile may
+    // have been open before the change even if it is blocked now.
+    const auto invalidate = [&](std::size_t tile) {
+        if (tile != targetTile && !marks[tile]) {
+            marks[tile] = 1;
+            touched.push_back(static_cast<std::uint32_t>(tile));
+        }
+    };
+    for (const std::uint32_t tile : changedTiles) {
+        invalidate(tile);
+        for (unsigned int step = 0; step < 8; ++step) {
+            const std::size_t other = neighbor(tile, step);
+            if (other != kOutside) invalidate(other);
+        }
+    }
+    changedTiles.clear();
+
+    // Tiles whose next step leads onto an invalidated tile, transitively.
+    for (std::size_t i = 0; i < touched.size(); ++i) {
+        const std::size_t tile = touched[i];
+        forEachNeighbor(tile, [&](unsigned int, std::size_t from) {
+            if (marks[from] || directions[from] == kNoDirection) return;
+            if (neighbor(from, directions[from]) == tile) {
+                marks[from] = 1;
+                touched.push_back(static_cast<std::uint32_t>(from));
+            }
+        });
+    }
+    const std::size_t invalidated = touched.size();
+    for (std::size_t i = 0; i < invalidated; ++i) {
+        costs[touched[i]] = kUnreachable;
+    }
+    for (std::size_t i = 0; i < invalidated; ++i) {
+        const std::size_t tile = touched[i];
+        if (terrainCosts[tile] == 0) continue;
+        std::uint32_t best = kUnreachable;
+        forEachNeighbor(tile, [&](unsigned int step, std::size_t to) {
+            if (costs[to] != kUnreachable) {
+                best = std::min(best, costs[to] + stepCost(tile, step));
+            }
+        });
+        if (best != kUnreachable) {
+            seed(best, tile);
+        }
+    }
+    propagate();
+
+    // A direction depends on the tile's own cost and its neighbours' costs.
+    for (const std::uint32_t tile : touched) {
+        updateDirection(tile);
+        forEachNeighbor(tile, [&](unsigned int, std::size_t other) { updateDirection(other); });
+    }
+    for (const std::uint32_t tile : touched) {
+        marks[tile] = 0;
+    }
+    lastUpdatedTileCount = touched.size();
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "Position.h"
+#include "Tile.h"
+#include "Vector2D.h"
+
+/**
+ * @brief Cheapest-path directions towards one target tile over terrain
+ *
+ * Every tile of a window around the target stores the compass direction
+ * (8-way) of its next step on a cheapest path to the target, so an ant
+ * heading there needs one lookup per tick. Path costs come from the terrain
+ * of the tile being left: SOIL and GRASS cost 1 per step, SAND 3, and ROCK
+ * cannot be crossed. Diagonal steps cost sqrt(2) times as much and are only
+ * taken when both orthogonal tiles they cut past can be crossed, so paths
+ * never squeeze between two ROCK tiles or around a ROCK corner.
+ *
+ * Costs are integers, so the cheapest cost of a tile is exact and does not
+ * depend on the order tiles were settled in, and directions are derived from
+ * those costs with a fixed tie-break. A field repaired after terrain changes
+ * is therefore identical to one built from scratch on the new terrain.
+ *
+ * Only a window of kRadius tiles around the target is covered, so on a huge
+ * world the field stays small and terrain far from the target is never read.
+ * Tiles outside the window, the target itself and tiles with no path read as
+ * a zero direction.
+ */
+class FlowField {
+public:
+    static constexpr unsigned int kRadius = 256;
+    // Step costs on unit-cost terrain, in tenths of a tile.
+    static constexpr std::uint32_t kStraightCost = 10;
+    static constexpr std::uint32_t kDiagonalCost = 14;
+    static constexpr std::uint32_t kUnreachable = std::numeric_limits<std::uint32_t>::max();
+
+    // Terrain of a tile inside the world.
+    using TerrainLookup = std::function<TerrainType(unsigned int x, unsigned int y)>;
+
+    FlowField(unsigned int worldWidth, unsigned int worldHeight);
+
+    // Builds the field if it was never built or `target` moved, otherwise
+    // repairs it around the tiles passed to markChanged() since the last
+    // call. Returns whether anything was recomputed.
+    bool update(const IntegerPosition& target, const TerrainLookup& terrainAt);
+
+    // Records that the terrain of `pos` changed; picked up by update().
+    void markChanged(const IntegerPosition& pos);
+
+    bool isBuilt() const { return built; }
+
+    Vector2D get(unsigned int x, unsigned int y) const {
+        const std::size_t i = indexOf(x, y);
+        return i == kOutside ? Vector2D() : kDirections[directions[i]];
+    }
+
+    // Cost of the cheapest path from (x, y) to the target, in tenths of a
+    // unit-cost step; kUnreachable outside the window or without a path.
+    std::uint32_t getCost(unsigned int x, unsigned int y) const {
+        const std::size_t i = indexOf(x, y);
+        return i == kOutside ? kUnreachable : costs[i];
+    }
+
+    // Tiles settled by the last update(), for profiling.
+    std::size_t getLastUpdatedTileCount() const { return lastUpdatedTileCount; }
+
+private:
+    static constexpr std::size_t kOutside = std::numeric_limits<std::size_t>::max();
+    static constexpr std::uint8_t kNoDirection = 8;
+    static constexpr std::array<Vector2D, 9> kDirections{{
+        { 0.0f, -1.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f }, { -1.0f, 0.0f },
+        { 0.70710677f, -0.70710677f }, { 0.70710677f, 0.70710677f },
+        { -0.70710677f, 0.70710677f }, { -0.70710677f, -0.70710677f },
+        { 0.0f, 0.0f },
+    }};
+    static constexpr std::array<int, 8> kStepX{ 0, 1, 0, -1, 1, 1, -1, -1 };
+    static constexpr std::array<int, 8> kStepY{ -1, 0, 1, 0, -1, 1, 1, -1 };
+
+    // Costs in the bucket queue lie within one step of the cost being
+    // settled, so a ring of buckets wider than the dearest step holds them.
+    static constexpr std::uint32_t kMaxTerrainCost = 3;
+    static constexpr std::size_t kBucketCount = 64;
+    static_assert(kDiagonalCost * kMaxTerrainCost < kBucketCount);
+
+    struct Seed {
+        std::uint32_t cost;
+        std::uint32_t tile;
+    };
+
+    unsigned int worldWidth;
+    unsigned int worldHeight;
+    IntegerPosition target;
+    std::size_t targetTile = 0;
+    unsigned int originX = 0;
+    unsigned int originY = 0;
+    unsigned int columns = 0;
+    unsigned int rows = 0;
+    bool built = false;
+
+    // Per window tile, row-major.
+    std::vector<std::uint32_t> costs;
+    std::vector<std::uint8_t> directions;
+    // Cost multiplier of leaving the tile; 0 means impassable.
+    std::vector<std::uint8_t> terrainCosts;
+
+    // Reused by every update() so repairs do not allocate.
+    std::vector<std::uint32_t> changedTiles;
+    std::vector<Seed> seeds;
+    std::array<std::vector<std::uint32_t>, kBucketCount> buckets;
+    std::size_t queuedCount = 0;
+    std::vector<std::uint32_t> touched;
+    // Non-zero for tiles on `touched`.
+    std::vector<std::uint8_t> marks;
+    std::size_t lastUpdatedTileCount = 0;
+
+    std::size_t indexOf(unsigned int x, unsigned int y) const {
+        const unsigned int column = x - originX;
+        const unsigned int row = y - originY;
+        // Coordinates left of or above the window wrap around and fail too.
+        return column < columns && row < rows ? static_cast<std::size_t>(row) * columns + column : kOutside;
+    }
+    // Window index of the neighbour of `tile` in direction `step`, or kOutside.
+    std::size_t neighbor(std::size_t tile, unsigned int step) const;
+    // Calls fn(step, neighbour) for each in-window neighbour of `tile` that
+    // can be reached in one step, skipping diagonals past impassable tiles.
+    template <typename Fn>
+    void forEachNeighbor(std::size_t tile, Fn&& fn) const;
+    std::uint32_t stepCost(std::size_t tile, unsigned int step) const {
+        return (step < 4 ? kStraightCost : kDiagonalCost) * terrainCosts[tile];
+    }
+    static std::uint8_t terrainCost(TerrainType terrain);
+
+    void build(const IntegerPosition& newTarget, const TerrainLookup& terrainAt);
+    void repair(const TerrainLookup& terrainAt);
+    // Sets the cost of `tile` and queues it: seed() at any cost before
+    // propagate(), push() within one step of the cost being settled.
+    void seed(std::uint32_t cost, std::size_t tile);
+    void push(std::uint32_t cost, std::size_t tile);
+    void touch(std::size_t tile);
+    // Settles the seeds in cost order, relaxing tiles that can step onto a
+    // settled one (Dijkstra with a bucket queue).
+    void propagate();
+    void updateDirection(std::size_t tile);
+};
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cmath>
+
+#include "AllocationCounter.h"
+#include "GradientField.h"
+#include "ThreadPool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANTS_GRADIENT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr unsigned int kBlockSize = PheromoneField::kBlockSize;
+constexpr std::size_t kBlockArea = PheromoneField::kBlockArea;
+
+// Reference for one tile; the row pass below performs the same operations.
+inline void normalizedGradient(float east, float west, float south, float north, float& outX, float& outY) {
+    const float gx = east - west;
+    const float gy = south - north;
+    const float magnitude = std::sqrt(gx * gx + gy * gy);
+    const bool steep = magnitude > GradientField::kMinMagnitude;
+    outX = steep ? gx / magnitude : 0.0f;
+    outY = steep ? gy / magnitude : 0.0f;
+}
+
+/**
+ * @brief Gradient of one block from its neighbourhood
+ *
+ * Tiles outside the world hold zero in the plane, so reading past the last
+ * column or row of a partial block yields the same zero a bounds check would.
+ * Missing neighbours (world border) read as zero too.
+ */
+void gradientBlock(const PheromoneField::BlockNeighborhood& source, float* outX, float* outY) {
+    alignas(16) static constexpr float zeroRow[kBlockSize] = {};
+    // Row padded with its left and right neighbours, so east and west are
+    // unaligned loads at offsets 2 and 0.
+    alignas(16) float extended[kBlockSize + 4];
+
+    for (unsigned int r = 0; r < kBlockSize; ++r) {
+        const float* row = source.self + r * kBlockSize;
+        const float* above = r > 0 ? row - kBlockSize
+                           : source.above ? source.above + (kBlockSize - 1) * kBlockSize : zeroRow;
+        const float* below = r + 1 < kBlockSize ? row + kBlockSize : source.below ? source.below : zeroRow;
+        extended[0] = source.left ? source.left[r * kBlockSize + kBlockSize - 1] : 0.0f;
+        std::copy(row, row + kBlockSize, extended + 1);
+        extended[kBlockSize + 1] = source.right ? source.right[r * kBlockSize] : 0.0f;
+
+        float* rowX = outX + r * kBlockSize;
+        float* rowY = outY + r * kBlockSize;
+#ifdef ANTS_GRADIENT_X86
+        const __m128 minMagnitude = _mm_set1_ps(GradientField::kMinMagnitude);
+        for (unsigned int c = 0; c < kBlockSize; c += 4) {
+            const __m128 gx = _mm_sub_ps(_mm_loadu_ps(extended + c + 2), _mm_loadu_ps(extended + c));
+            const __m128 gy = _mm_sub_ps(_mm_load_ps(below + c), _mm_load_ps(above + c));
+            const __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gy, gy)));
+            const __m128 steep = _mm_cmpgt_ps(magnitude, minMagnitude);
+            // Flat lanes divide 0 by 0; the mask clears the NaN.
+            _mm_store_ps(rowX + c, _mm_and_ps(steep, _mm_div_ps(gx, magnitude)));
+            _mm_store_ps(rowY + c, _mm_and_ps(steep, _mm_div_ps(gy, magnitude)));
+        }
+#else
+        for (unsigned int c = 0; c < kBlockSize; ++c) {
+            normalizedGradient(extended[c + 2], extended[c], below[c], above[c], rowX[c], rowY[c]);
+        }
+#endif
+    }
+}
+
+} // namespace
+
+GradientField::GradientField(unsigned int width, unsigned int height)
+    : blocksX((width + kBlockSize - 1) / kBlockSize),
+      blocksY((height + kBlockSize - 1) / kBlockSize),
+      slotOfBlock(static_cast<std::size_t>(blocksX) * blocksY) {
+}
+
+bool GradientField::update(const PheromoneField& field, PheromoneType type, ThreadPool* pool) {
+    if (isCurrent(field)) return false;
+    revision = field.getRevision();
+    built = true;
+
+    for (const std::uint32_t block : blocks) {
+        slotOfBlock.reset(block);
+    }
+    blocks.clear();
+    // Each active block brings at most itself and four neighbours. Buffers
+    // grow to twice what is needed, so a trail spreading over new ground
+    // allocates a logarithmic number of times and a trail within its
+    // previous extent not at all.
+    const std::size_t totalBlocks = static_cast<std::size_t>(blocksX) * blocksY;
+    const std::size_t maxBlocks = std::min(totalBlocks, 5 * field.getActiveBlocks(type).size());
+    if (blocks.capacity() < maxBlocks) {
+        allocation_counter::LazyGrowthScope growth;
+        blocks.reserve(std::min(totalBlocks, 2 * maxBlocks));
+    }
+    auto enqueue = [this](std::size_t block) {
+        std::uint32_t& slot = slotOfBlock.at(block);
+        if (slot == 0) {
+            blocks.push_back(static_cast<std::uint32_t>(block));
+            slot = static_cast<std::uint32_t>(blocks.size());
+        }
+    };
+    for (const std::uint32_t block : field.getActiveBlocks(type)) {
+        const unsigned int bx = block % blocksX;
+        const unsigned int by = block / blocksX;
+        enqueue(block);
+        if (by > 0) enqueue(block - blocksX);
+        if (by + 1 < blocksY) enqueue(block + blocksX);
+        if (bx > 0) enqueue(block - 1);
+        if (bx + 1 < blocksX) enqueue(block + 1);
+    }
+    if (gradientX.size() < blocks.size() * kBlockArea) {
+        allocation_counter::LazyGrowthScope growth;
+        const std::size_t slots = std::min(totalBlocks, 2 * blocks.size());
+        gradientX.resize(slots * kBlockArea);
+        gradientY.resize(slots * kBlockArea);
+    }
+
+    auto computeBlocks = [&](std::size_t begin, std::size_t end, unsigned int) {
+        for (std::size_t i = begin; i < end; ++i) {
+            gradientBlock(field.getNeighborhood(type, blocks[i]), gradientX.data() + i * kBlockArea,
+                          gradientY.data() + i * kBlockArea);
+        }
+    };
+    static constexpr std::size_t kBlocksPerChunk = 4;
+    if (pool) {
+        pool->parallelFor(blocks.size(), kBlocksPerChunk, computeBlocks);
+    } else {
+        computeBlocks(0, blocks.size(), 0);
+    }
+    return true;
+}
+
+Vector2D GradientField::compute(const PheromoneField& field, PheromoneType type, unsigned int x, unsigned int y) {
+    auto at = [&](unsigned int px, unsigned int py) {
+        return px < field.getWidth() && py < field.getHeight() ? field.get(px, py, type) : 0.0f;
+    };
+    Vector2D gradient;
+    // x - 1 and y - 1 wrap around at the border and read as zero.
+    normalizedGradient(at(x + 1, y), at(x - 1, y), at(x, y + 1), at(x, y - 1), gradient.x, gradient.y);
+    return gradient;
+}
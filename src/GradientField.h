@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PagedTable.h"
+#include "Pheromone.h"
+#include "PheromoneField.h"
+#include "Vector2D.h"
+
+class ThreadPool;
+
+/**
+ * @brief Normalized gradient of one pheromone plane, rebuilt once per tick
+ *
+ * The gradient at a tile is the central difference (east - west,
+ * south - north) of the plane, normalized, or zero where its magnitude is at
+ * most kMinMagnitude. Neighbours outside the world read as zero.
+ *
+ * Storage mirrors the plane's blocks: only active blocks and their
+ * 4-neighbour halo can have a non-zero gradient, so only those are computed
+ * and stored; every other tile reads as zero. update() skips the rebuild while
+ * the plane's revision is unchanged.
+ */
+class GradientField {
+public:
+    static constexpr float kMinMagnitude = 0.001f;
+
+    GradientField(unsigned int width, unsigned int height);
+
+    // Rebuilds from `type` of `field` unless nothing changed since the last
+    // call. Returns whether it rebuilt.
+    bool update(const PheromoneField& field, PheromoneType type, ThreadPool* pool = nullptr);
+
+    // Whether the field reflects the current state of `field`.
+    bool isCurrent(const PheromoneField& field) const { return built && revision == field.getRevision(); }
+
+    Vector2D get(unsigned int x, unsigned int y) const {
+        const std::uint32_t slot = slotOfBlock.get(
+            static_cast<std::size_t>(y >> PheromoneField::kBlockShift) * blocksX + (x >> PheromoneField::kBlockShift));
+        if (slot == 0) return Vector2D();
+        const std::size_t i = (slot - 1) * PheromoneField::kBlockArea +
+                              ((y & (PheromoneField::kBlockSize - 1)) << PheromoneField::kBlockShift) +
+                              (x & (PheromoneField::kBlockSize - 1));
+        return Vector2D(gradientX[i], gradientY[i]);
+    }
+
+    // Blocks holding a computed gradient.
+    std::size_t getBlockCount() const { return blocks.size(); }
+
+    // The same gradient computed directly from the plane, for callers that
+    // cannot rely on the field being current.
+    static Vector2D compute(const PheromoneField& field, PheromoneType type, unsigned int x, unsigned int y);
+
+private:
+    unsigned int blocksX;
+    unsigned int blocksY;
+    // Block index -> slot + 1; 0 means the gradient is zero everywhere in it.
+    PagedTable<std::uint32_t> slotOfBlock;
+    std::vector<std::uint32_t> blocks;
+    // kBlockArea values per slot, row-major like the plane's blocks.
+    std::vector<float> gradientX;
+    std::vector<float> gradientY;
+    std::uint64_t revision = 0;
+    bool built = false;
+};
@@ -6,4 +6,8 @@ private:
 
 public:
     int getNextId();
+
+    // The id the next getNextId() call returns; used by snapshots.
+    int peekNextId() const { return nextId; }
+    void setNextId(int id) { nextId = id; }
 };
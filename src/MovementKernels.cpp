@@ -0,0 +1,173 @@
+#include "MovementKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANTS_MOVEMENT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace movement_kernels {
+
+namespace {
+
+void peekUnitVectorsScalar(const CounterRng* rngs, std::size_t count, Vector2D* out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        CounterRng next = rngs[i];
+        out[i] = unitVectorFromBits(next());
+    }
+}
+
+void decideWanderScalar(const Vector2D* lastDirections, CounterRng* rngs, std::size_t count,
+                        float randomness, Vector2D* directions) {
+    for (std::size_t i = 0; i < count; ++i) {
+        directions[i] = wander(lastDirections[i], randomness, rngs[i]());
+    }
+}
+
+#ifdef ANTS_MOVEMENT_X86
+
+__attribute__((target("avx2")))
+inline __m256i mix32(__m256i x) {
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846ca68bu)));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256 polynomial(__m256 x2, const float* coefficients, int count) {
+    __m256 result = _mm256_set1_ps(coefficients[count - 1]);
+    for (int k = count - 2; k >= 0; --k) {
+        result = _mm256_add_ps(_mm256_set1_ps(coefficients[k]), _mm256_mul_ps(x2, result));
+    }
+    return result;
+}
+
+// Same Horner order as sinQuadrant()/cosQuadrant().
+constexpr float kSin[] = { 1.0f, -1.0f / 6.0f, 1.0f / 120.0f, -1.0f / 5040.0f,
+                           1.0f / 362880.0f, -1.0f / 39916800.0f };
+constexpr float kCos[] = { 1.0f, -1.0f / 2.0f, 1.0f / 24.0f, -1.0f / 720.0f,
+                           1.0f / 40320.0f, -1.0f / 3628800.0f, 1.0f / 479001600.0f };
+
+// unitVectorFromBits() of the next draw of rngs[0..8), streams untouched.
+__attribute__((target("avx2")))
+inline void peekUnitVectors8(const CounterRng* rngs, __m256& randomX, __m256& randomY) {
+    alignas(32) std::uint32_t keyLow[8], keyHigh[8], counters[8];
+    for (int lane = 0; lane < 8; ++lane) {
+        const std::uint64_t key = rngs[lane].getKey();
+        keyLow[lane] = static_cast<std::uint32_t>(key);
+        keyHigh[lane] = static_cast<std::uint32_t>(key >> 32);
+        counters[lane] = rngs[lane].getCounter();
+    }
+
+    const __m256i counter = _mm256_load_si256(reinterpret_cast<const __m256i*>(counters));
+    const __m256i low = _mm256_load_si256(reinterpret_cast<const __m256i*>(keyLow));
+    const __m256i high = _mm256_load_si256(reinterpret_cast<const __m256i*>(keyHigh));
+    const __m256i bits = mix32(_mm256_add_epi32(mix32(_mm256_xor_si256(counter, low)), high));
+
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i quadrant = _mm256_srli_epi32(bits, 30);
+    const __m256 angle = _mm256_mul_ps(
+        _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(bits, 6), _mm256_set1_epi32(0xFFFFFF))),
+        _mm256_set1_ps(kQuadrantAngleScale));
+    const __m256 angle2 = _mm256_mul_ps(angle, angle);
+    const __m256 s = _mm256_mul_ps(angle, polynomial(angle2, kSin, 6));
+    const __m256 c = polynomial(angle2, kCos, 7);
+
+    const __m256 odd = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+    const __m256i negateX = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(_mm256_add_epi32(quadrant, one), 1), one), 31);
+    const __m256i negateY = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(quadrant, 1), one), 31);
+    randomX = _mm256_xor_ps(_mm256_blendv_ps(c, s, odd), _mm256_castsi256_ps(negateX));
+    randomY = _mm256_xor_ps(_mm256_blendv_ps(s, c, odd), _mm256_castsi256_ps(negateY));
+}
+
+__attribute__((target("avx2")))
+void peekUnitVectorsAvx2(const CounterRng* rngs, std::size_t count, Vector2D* out) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 randomX, randomY;
+        peekUnitVectors8(rngs + i, randomX, randomY);
+        alignas(32) float outX[8], outY[8];
+        _mm256_store_ps(outX, randomX);
+        _mm256_store_ps(outY, randomY);
+        for (int lane = 0; lane < 8; ++lane) {
+            out[i + lane] = Vector2D(outX[lane], outY[lane]);
+        }
+    }
+    peekUnitVectorsScalar(rngs + i, count - i, out + i);
+}
+
+__attribute__((target("avx2")))
+void decideWanderAvx2(const Vector2D* lastDirections, CounterRng* rngs, std::size_t count,
+                      float randomness, Vector2D* directions) {
+    const __m256 keep = _mm256_set1_ps(1.0f - randomness);
+    const __m256 mix = _mm256_set1_ps(randomness);
+    const __m256 minMagnitude = _mm256_set1_ps(Vector2D::kNormalizeEpsilon);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        alignas(32) float lastX[8], lastY[8];
+        for (int lane = 0; lane < 8; ++lane) {
+            lastX[lane] = lastDirections[i + lane].x;
+            lastY[lane] = lastDirections[i + lane].y;
+        }
+        __m256 randomX, randomY;
+        peekUnitVectors8(rngs + i, randomX, randomY);
+        for (int lane = 0; lane < 8; ++lane) {
+            rngs[i + lane].discard(1);
+        }
+
+        const __m256 x = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(lastX), keep), _mm256_mul_ps(randomX, mix));
+        const __m256 y = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(lastY), keep), _mm256_mul_ps(randomY, mix));
+        const __m256 magnitude = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+        const __m256 valid = _mm256_cmp_ps(magnitude, minMagnitude, _CMP_GE_OQ);
+
+        alignas(32) float outX[8], outY[8];
+        _mm256_store_ps(outX, _mm256_and_ps(valid, _mm256_div_ps(x, magnitude)));
+        _mm256_store_ps(outY, _mm256_and_ps(valid, _mm256_div_ps(y, magnitude)));
+        for (int lane = 0; lane < 8; ++lane) {
+            directions[i + lane] = Vector2D(outX[lane], outY[lane]);
+        }
+    }
+    decideWanderScalar(lastDirections + i, rngs + i, count - i, randomness, directions + i);
+}
+
+using WanderKernel = void (*)(const Vector2D*, CounterRng*, std::size_t, float, Vector2D*);
+
+WanderKernel selectWanderKernel() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? decideWanderAvx2 : decideWanderScalar;
+}
+
+using PeekKernel = void (*)(const CounterRng*, std::size_t, Vector2D*);
+
+PeekKernel selectPeekKernel() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? peekUnitVectorsAvx2 : peekUnitVectorsScalar;
+}
+
+#endif
+
+} // namespace
+
+void decideWander(const Vector2D* lastDirections, CounterRng* rngs, std::size_t count,
+                  float randomness, Vector2D* directions) {
+#ifdef ANTS_MOVEMENT_X86
+    static const WanderKernel kernel = selectWanderKernel();
+    kernel(lastDirections, rngs, count, randomness, directions);
+#else
+    decideWanderScalar(lastDirections, rngs, count, randomness, directions);
+#endif
+}
+
+void peekUnitVectors(const CounterRng* rngs, std::size_t count, Vector2D* out) {
+#ifdef ANTS_MOVEMENT_X86
+    static const PeekKernel kernel = selectPeekKernel();
+    kernel(rngs, count, out);
+#else
+    peekUnitVectorsScalar(rngs, count, out);
+#endif
+}
+
+} // namespace movement_kernels
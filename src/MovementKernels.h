@@ -0,0 +1,104 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "Ant.h"
+#include "Random.h"
+#include "Vector2D.h"
+
+/**
+ * @brief Batched, statically dispatched decide kernels
+ *
+ * Workers, nurses, soldiers and drones all decide the same way: keep the
+ * last direction, mix in a random unit vector with a role constant and
+ * renormalise. decideWander() does that for a contiguous run of ants of one
+ * role, 8 at a time with AVX2 when available. The scalar helpers below are
+ * the reference the SIMD path matches bit for bit, and are what the
+ * MovementStrategy classes use, so batched and one-at-a-time updates agree.
+ */
+namespace movement_kernels {
+
+constexpr float kWorkerRandomness = 0.2f;
+constexpr float kNurseRandomness = 0.5f;
+constexpr float kSoldierRandomness = 0.4f;
+constexpr float kDroneRandomness = 0.1f;
+
+constexpr bool isWanderRole(AntRole role) {
+    return role == AntRole::WORKER || role == AntRole::NURSE ||
+           role == AntRole::SOLDIER || role == AntRole::DRONE;
+}
+
+constexpr float wanderRandomnessFor(AntRole role) {
+    switch (role) {
+        case AntRole::WORKER:  return kWorkerRandomness;
+        case AntRole::NURSE:   return kNurseRandomness;
+        case AntRole::SOLDIER: return kSoldierRandomness;
+        case AntRole::DRONE:   return kDroneRandomness;
+        default:               return 0.0f;
+    }
+}
+
+// The top two bits of a draw pick the quadrant, the next 24 the angle within
+// it, so sin/cos only need polynomials on [0, pi/2).
+constexpr float kQuadrantAngleScale = 1.57079632679489661923f / 16777216.0f;
+
+inline float sinQuadrant(float x) {
+    const float x2 = x * x;
+    return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f +
+           x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+}
+
+inline float cosQuadrant(float x) {
+    const float x2 = x * x;
+    return 1.0f + x2 * (-1.0f / 2.0f + x2 * (1.0f / 24.0f + x2 * (-1.0f / 720.0f +
+           x2 * (1.0f / 40320.0f + x2 * (-1.0f / 3628800.0f + x2 * (1.0f / 479001600.0f))))));
+}
+
+inline float flipSign(float value, std::uint32_t negate) {
+    return std::bit_cast<float>(std::bit_cast<std::uint32_t>(value) ^ (negate << 31));
+}
+
+// Uniformly distributed unit vector from one 32-bit random draw.
+inline Vector2D unitVectorFromBits(std::uint32_t bits) {
+    const std::uint32_t quadrant = bits >> 30;
+    const float angle = static_cast<float>((bits >> 6) & 0xFFFFFFu) * kQuadrantAngleScale;
+    const float s = sinQuadrant(angle);
+    const float c = cosQuadrant(angle);
+    const bool odd = quadrant & 1u;
+    const float x = odd ? s : c;
+    const float y = odd ? c : s;
+    return Vector2D(flipSign(x, ((quadrant + 1) >> 1) & 1u), flipSign(y, (quadrant >> 1) & 1u));
+}
+
+// normalize(direction * (1 - randomness) + randomUnit * randomness)
+inline Vector2D wanderTowards(const Vector2D& direction, float randomness, const Vector2D& randomUnit) {
+    const Vector2D randomComponent = randomUnit * randomness;
+    return (direction * (1.0f - randomness) + randomComponent).normalized();
+}
+
+inline Vector2D wander(const Vector2D& direction, float randomness, std::uint32_t bits) {
+    return wanderTowards(direction, randomness, unitVectorFromBits(bits));
+}
+
+/**
+ * @brief Unit vector of each stream's next draw, without drawing
+ *
+ * out[i] is unitVectorFromBits() of the value rngs[i]() would return next;
+ * the streams are left untouched, so a caller that ends up not needing a
+ * vector does not shift the stream. 8 at a time with AVX2 when available.
+ */
+void peekUnitVectors(const CounterRng* rngs, std::size_t count, Vector2D* out);
+
+/**
+ * @brief Wander decision for `count` ants of one role
+ *
+ * Reads lastDirections[i], draws once from rngs[i] and writes the new
+ * direction to directions[i].
+ */
+void decideWander(const Vector2D* lastDirections, CounterRng* rngs, std::size_t count,
+                  float randomness, Vector2D* directions);
+
+} // namespace movement_kernels
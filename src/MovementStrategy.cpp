@@ -1,44 +1,38 @@
-#include <random>
-
+#include "MovementKernels.h"
 #include "MovementStrategy.h"
 #include "Vector2D.h"
 #include "Position.h"
 
-
-Vector2D MovementStrategy::getRandomDirection() const {
-    std::uniform_real_distribution<float> dist(0, 2 * M_PI);
-    float angle = dist(rng);
-    return Vector2D(std::cos(angle), std::sin(angle));
+Vector2D MovementStrategy::getRandomDirection(RandomDirections& random) {
+    return random.next();
 }
 
-Vector2D MovementStrategy::directionTowards(const FloatPosition& position, const FloatPosition& target) const {
+Vector2D MovementStrategy::directionTowards(const FloatPosition& position, const FloatPosition& target, RandomDirections& random) {
     const auto diff = (target - position).toVector2D();
-    if (diff.magnitude() < 0.001f) return getRandomDirection();
+    if (diff.magnitude() < 0.001f) return getRandomDirection(random);
     return diff.normalized();
 }
 
-Vector2D MovementStrategy::addRandomnessToDirection(const Vector2D& direction, float randomness) const {
-    const auto randomComponent = getRandomDirection() * randomness;
-    const auto result = direction * (1.0f - randomness) + randomComponent;
-    return result.normalized();
+Vector2D MovementStrategy::addRandomnessToDirection(const Vector2D& direction, float randomness, RandomDirections& random) {
+    return movement_kernels::wanderTowards(direction, randomness, random.next());
 }
 
-MovementDecision QueenMovementStrategy::decide(const SensoryInput& input) {
+MovementDecision QueenMovementStrategy::decide(const SensoryInput& input, RandomDirections& random) const {
     if (input.distanceToNest > 0.5) {
-        return { directionTowards(input.position, input.nestEntrancePosition), {} };
+        return { directionTowards(input.position, input.nestEntrancePosition, random), {} };
     }
-    return { getRandomDirection() * 0.1f, {} };
+    return { getRandomDirection(random) * 0.1f, {} };
 }
 
-MovementDecision WorkerMovementStrategy::decide(const SensoryInput& input) {
-    return { addRandomnessToDirection(input.lastDirection, 0.2f), {} };
+MovementDecision WorkerMovementStrategy::decide(const SensoryInput& input, RandomDirections& random) const {
+    return { addRandomnessToDirection(input.lastDirection, movement_kernels::kWorkerRandomness, random), {} };
 }
 
-MovementDecision NurseMovementStrategy::decide(const SensoryInput& input) {
-    return { addRandomnessToDirection(input.lastDirection, 0.5f), {} };
+MovementDecision NurseMovementStrategy::decide(const SensoryInput& input, RandomDirections& random) const {
+    return { addRandomnessToDirection(input.lastDirection, movement_kernels::kNurseRandomness, random), {} };
 }
 
-MovementDecision ForagerMovementStrategy::decide(const SensoryInput& input) {
+MovementDecision ForagerMovementStrategy::decide(const SensoryInput& input, RandomDirections& random) const {
     MovementDecision decision;
     float projectedLoad = input.currentLoad;
 
@@ -64,18 +58,38 @@ MovementDecision ForagerMovementStrategy::decide(const SensoryInput& input) {
         // Follow the strongest scent; wander still mixes in via the randomness pass.
         baseDirection = input.foodTrailGradient;
     }
-    decision.direction = addRandomnessToDirection(baseDirection, input.wanderRandomness);
+    decision.direction = addRandomnessToDirection(baseDirection, input.wanderRandomness, random);
     return decision;
 }
 
-MovementDecision SoldierMovementStrategy::decide(const SensoryInput& input) {
-    return { addRandomnessToDirection(input.lastDirection, 0.4f), {} };
+MovementDecision SoldierMovementStrategy::decide(const SensoryInput& input, RandomDirections& random) const {
+    return { addRandomnessToDirection(input.lastDirection, movement_kernels::kSoldierRandomness, random), {} };
+}
+
+MovementDecision DroneMovementStrategy::decide(const SensoryInput& input, RandomDirections& random) const {
+    return { addRandomnessToDirection(input.lastDirection, movement_kernels::kDroneRandomness, random), {} };
 }
 
-MovementDecision DroneMovementStrategy::decide(const SensoryInput& input) {
-    return { addRandomnessToDirection(input.lastDirection, 0.1f), {} };
+MovementDecision DefaultMovementStrategy::decide(const SensoryInput& input, RandomDirections& random) const {
+    return { getRandomDirection(random), {} };
 }
 
-MovementDecision DefaultMovementStrategy::decide(const SensoryInput& input) {
-    return { getRandomDirection(), {} };
+MovementDecision decideMovement(AntRole role, const SensoryInput& input, RandomDirections& random) {
+    static const QueenMovementStrategy queen;
+    static const WorkerMovementStrategy worker;
+    static const SoldierMovementStrategy soldier;
+    static const DroneMovementStrategy drone;
+    static const ForagerMovementStrategy forager;
+    static const NurseMovementStrategy nurse;
+    static const DefaultMovementStrategy fallback;
+
+    switch (role) {
+        case AntRole::QUEEN:   return queen.decide(input, random);
+        case AntRole::WORKER:  return worker.decide(input, random);
+        case AntRole::SOLDIER: return soldier.decide(input, random);
+        case AntRole::DRONE:   return drone.decide(input, random);
+        case AntRole::FORAGER: return forager.decide(input, random);
+        case AntRole::NURSE:   return nurse.decide(input, random);
+    }
+    return fallback.decide(input, random);
 }
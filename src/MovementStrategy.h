@@ -1,12 +1,15 @@
 #pragma once
 
-#include <vector>
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <variant>
 #include <optional>
-#include <random>
 #include <string>
+#include "MovementKernels.h"
 #include "Pheromone.h"
 #include "Position.h"
+#include "Random.h"
 #include "Vector2D.h"
 #include "Ant.h"
 
@@ -29,9 +32,32 @@ using MovementAction = std::variant<
     movement_actions::SetDestination
 >;
 
+// Fixed-capacity action list stored inline in the decision, so deciding
+// never touches the allocator. Capacity covers the longest sequence any
+// strategy emits (forager: pick up, deposit, drop/set destination).
+class MovementActions {
+public:
+    static constexpr std::size_t kCapacity = 4;
+
+private:
+    std::array<MovementAction, kCapacity> actions{};
+    std::size_t count = 0;
+
+public:
+    void push_back(const MovementAction& action) {
+        assert(count < kCapacity && "MovementActions capacity exceeded");
+        actions[count++] = action;
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const MovementAction* begin() const { return actions.data(); }
+    const MovementAction* end() const { return actions.data() + count; }
+};
+
 struct MovementDecision {
     Vector2D direction;
-    std::vector<MovementAction> actions;
+    MovementActions actions;
 };
 
 // Snapshot of everything a strategy is allowed to observe about the ant and
@@ -58,57 +84,85 @@ struct SensoryInput {
     FloatPosition nestEntrancePosition;
 };
 
-// Base strategy class
+// Random unit vectors drawn from the deciding ant's own stream. The vector for
+// the next draw may be handed in precomputed (movement_kernels::
+// peekUnitVectors() fills them for a whole batch); the stream only advances
+// when a vector is actually taken, so a strategy that takes none, one or
+// several sees exactly the values it would drawing from the stream itself.
+class RandomDirections {
+private:
+    CounterRng* rng;
+    const Vector2D* prefetched;
+
+public:
+    explicit RandomDirections(CounterRng& rng, const Vector2D* prefetched = nullptr)
+        : rng(&rng), prefetched(prefetched) {}
+
+    Vector2D next() {
+        if (prefetched) {
+            const Vector2D direction = *prefetched;
+            prefetched = nullptr;
+            rng->discard(1);
+            return direction;
+        }
+        return movement_kernels::unitVectorFromBits((*rng)());
+    }
+};
+
+// Base strategy class. Randomness comes from the deciding ant's own stream,
+// so strategies are stateless and can be shared by every ant of a role,
+// across threads.
 class MovementStrategy {
 protected:
-    std::mt19937& rng;
-    Vector2D getRandomDirection() const;
-    Vector2D directionTowards(const FloatPosition& position, const FloatPosition& target) const;
-    Vector2D addRandomnessToDirection(const Vector2D& direction, float randomness) const;
+    static Vector2D getRandomDirection(RandomDirections& random);
+    static Vector2D directionTowards(const FloatPosition& position, const FloatPosition& target, RandomDirections& random);
+    static Vector2D addRandomnessToDirection(const Vector2D& direction, float randomness, RandomDirections& random);
 public:
-    explicit MovementStrategy(std::mt19937& rng) : rng(rng) {}
-    virtual MovementDecision decide(const SensoryInput& input) = 0;
+    virtual MovementDecision decide(const SensoryInput& input, RandomDirections& random) const = 0;
     virtual ~MovementStrategy() = default;
 };
 
-class QueenMovementStrategy : public MovementStrategy {
+class QueenMovementStrategy final : public MovementStrategy {
 public:
-    using MovementStrategy::MovementStrategy;
-    MovementDecision decide(const SensoryInput& input) override;
+    MovementDecision decide(const SensoryInput& input, RandomDirections& random) const override;
 };
 
-class WorkerMovementStrategy : public MovementStrategy {
+class WorkerMovementStrategy final : public MovementStrategy {
 public:
-    using MovementStrategy::MovementStrategy;
-    MovementDecision decide(const SensoryInput& input) override;
+    MovementDecision decide(const SensoryInput& input, RandomDirections& random) const override;
 };
 
-class NurseMovementStrategy : public MovementStrategy {
+class NurseMovementStrategy final : public MovementStrategy {
 public:
-    using MovementStrategy::MovementStrategy;
-    MovementDecision decide(const SensoryInput& input) override;
+    MovementDecision decide(const SensoryInput& input, RandomDirections& random) const override;
 };
 
-class ForagerMovementStrategy : public MovementStrategy {
+class ForagerMovementStrategy final : public MovementStrategy {
 public:
-    using MovementStrategy::MovementStrategy;
-    MovementDecision decide(const SensoryInput& input) override;
+    MovementDecision decide(const SensoryInput& input, RandomDirections& random) const override;
 };
 
-class SoldierMovementStrategy : public MovementStrategy {
+class SoldierMovementStrategy final : public MovementStrategy {
 public:
-    using MovementStrategy::MovementStrategy;
-    MovementDecision decide(const SensoryInput& input) override;
+    MovementDecision decide(const SensoryInput& input, RandomDirections& random) const override;
 };
 
-class DroneMovementStrategy : public MovementStrategy {
+class DroneMovementStrategy final : public MovementStrategy {
 public:
-    using MovementStrategy::MovementStrategy;
-    MovementDecision decide(const SensoryInput& input) override;
+    MovementDecision decide(const SensoryInput& input, RandomDirections& random) const override;
 };
 
-class DefaultMovementStrategy : public MovementStrategy {
+class DefaultMovementStrategy final : public MovementStrategy {
 public:
-    using MovementStrategy::MovementStrategy;
-    MovementDecision decide(const SensoryInput& input) override;
+    MovementDecision decide(const SensoryInput& input, RandomDirections& random) const override;
 };
+
+// Statically dispatched decide for ants updated one at a time: switches on
+// the role and calls the concrete (final) strategy directly, no vtable.
+// Wander roles are normally decided in batches by movement_kernels instead.
+MovementDecision decideMovement(AntRole role, const SensoryInput& input, RandomDirections& random);
+
+inline MovementDecision decideMovement(AntRole role, const SensoryInput& input, CounterRng& rng) {
+    RandomDirections random(rng);
+    return decideMovement(role, input, random);
+}
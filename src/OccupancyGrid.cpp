@@ -0,0 +1,58 @@
+#include "OccupancyGrid.h"
+
+OccupancyGrid::OccupancyGrid(unsigned int width, unsigned int height, unsigned int cellShift)
+    : width(width),
+      height(height),
+      cellShift(cellShift),
+      cellsX(((width - 1) >> cellShift) + 1),
+      cellsY(((height - 1) >> cellShift) + 1),
+      cellStart(static_cast<std::size_t>(cellsX) * cellsY + 1, 0) {
+}
+
+unsigned int OccupancyGrid::chooseCellShift(unsigned int width, unsigned int height, std::size_t antCount) {
+    static constexpr std::size_t kMinCellBudget = 1 << 16;
+    const std::size_t cellBudget = std::max(kMinCellBudget, antCount * 2);
+    unsigned int shift = 0;
+    while (shift < 16) {
+        const std::size_t cells = static_cast<std::size_t>(((width - 1) >> shift) + 1) * (((height - 1) >> shift) + 1);
+        if (cells <= cellBudget) break;
+        ++shift;
+    }
+    return shift;
+}
+
+void OccupancyGrid::rebuild(std::span<const FloatPosition> positions) {
+    const std::size_t antCount = positions.size();
+    antCell.resize(antCount);
+    sortedAnts.resize(antCount);
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+
+    // Counting sort: histogram, exclusive prefix sum, stable scatter.
+    for (std::size_t i = 0; i < antCount; ++i) {
+        const IntegerPosition tile = positions[i].toIntegerPosition();
+        const unsigned int x = std::min(tile.getIntX(), width - 1);
+        const unsigned int y = std::min(tile.getIntY(), height - 1);
+        antCell[i] = static_cast<std::uint32_t>(cellIndex(x >> cellShift, y >> cellShift));
+        ++cellStart[antCell[i] + 1];
+    }
+    for (std::size_t cell = 1; cell < cellStart.size(); ++cell) {
+        cellStart[cell] += cellStart[cell - 1];
+    }
+    for (std::size_t i = 0; i < antCount; ++i) {
+        sortedAnts[cellStart[antCell[i]]++] = static_cast<std::uint32_t>(i);
+    }
+    // The scatter advanced each start to the next cell's start; shift back.
+    for (std::size_t cell = cellStart.size() - 1; cell > 0; --cell) {
+        cellStart[cell] = cellStart[cell - 1];
+    }
+    cellStart[0] = 0;
+}
+
+std::size_t OccupancyGrid::countInTile(unsigned int x, unsigned int y, std::span<const FloatPosition> positions) const {
+    if (cellShift == 0) {
+        return antsInCell(x, y).size();
+    }
+    std::size_t count = 0;
+    forEachAntInRect(x, y, x, y, positions, [&count](std::uint32_t) { ++count; });
+    return count;
+}
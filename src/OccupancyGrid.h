@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Position.h"
+
+/**
+ * @brief Uniform-grid index of ant positions, rebuilt by counting sort
+ *
+ * The world is cut into square cells of 2^cellShift tiles. rebuild() sorts
+ * ant indices by cell so the ants of one cell, and of a run of horizontally
+ * adjacent cells, are a contiguous span. Queries then only touch the cells
+ * overlapping the query area. Rebuilding is O(ants + cells) and reuses its
+ * buffers, so it does not allocate once the colony has stopped growing.
+ */
+class OccupancyGrid {
+private:
+    unsigned int width;
+    unsigned int height;
+    unsigned int cellShift;
+    unsigned int cellsX;
+    unsigned int cellsY;
+    std::vector<std::uint32_t> cellStart;   // cells + 1 prefix offsets into sortedAnts
+    std::vector<std::uint32_t> antCell;     // per ant, scratch for rebuild()
+    std::vector<std::uint32_t> sortedAnts;  // ant indices ordered by cell
+
+    std::size_t cellIndex(unsigned int cx, unsigned int cy) const {
+        return static_cast<std::size_t>(cy) * cellsX + cx;
+    }
+
+public:
+    /**
+     * @param cellShift log2 of the cell edge length in tiles
+     */
+    OccupancyGrid(unsigned int width, unsigned int height, unsigned int cellShift);
+
+    /**
+     * @brief Picks the smallest cell size keeping the cell count near the ant count
+     *
+     * Small worlds get one cell per tile; huge sparse worlds get coarser
+     * cells so the grid stays proportional to the colony, not the map.
+     */
+    static unsigned int chooseCellShift(unsigned int width, unsigned int height, std::size_t antCount);
+
+    void rebuild(std::span<const FloatPosition> positions);
+
+    unsigned int getCellShift() const { return cellShift; }
+    unsigned int getCellSize() const { return 1u << cellShift; }
+
+    // Ant indices whose position lies in cell (cx, cy).
+    std::span<const std::uint32_t> antsInCell(unsigned int cx, unsigned int cy) const {
+        const std::size_t cell = cellIndex(cx, cy);
+        return std::span<const std::uint32_t>(sortedAnts).subspan(cellStart[cell], cellStart[cell + 1] - cellStart[cell]);
+    }
+
+    /**
+     * @brief Calls fn(span) once per row of cells overlapping tiles [x0, x1] x [y0, y1]
+     *
+     * Each span is contiguous and may include ants slightly outside the
+     * rectangle (cells are coarser than tiles); use forEachAntInRect() for an
+     * exact filter.
+     */
+    template<typename Fn>
+    void forEachSpanInRect(int x0, int y0, int x1, int y1, Fn&& fn) const {
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, static_cast<int>(width) - 1);
+        y1 = std::min(y1, static_cast<int>(height) - 1);
+        if (x0 > x1 || y0 > y1) return;
+        const unsigned int cx0 = static_cast<unsigned int>(x0) >> cellShift;
+        const unsigned int cx1 = static_cast<unsigned int>(x1) >> cellShift;
+        for (unsigned int cy = static_cast<unsigned int>(y0) >> cellShift; cy <= (static_cast<unsigned int>(y1) >> cellShift); ++cy) {
+            const std::uint32_t begin = cellStart[cellIndex(cx0, cy)];
+            const std::uint32_t end = cellStart[cellIndex(cx1, cy) + 1];
+            if (begin != end) {
+                fn(std::span<const std::uint32_t>(sortedAnts).subspan(begin, end - begin));
+            }
+        }
+    }
+
+    // Calls fn(antIndex) for every ant whose tile lies in [x0, x1] x [y0, y1].
+    template<typename Fn>
+    void forEachAntInRect(int x0, int y0, int x1, int y1, std::span<const FloatPosition> positions, Fn&& fn) const {
+        forEachSpanInRect(x0, y0, x1, y1, [&](std::span<const std::uint32_t> ants) {
+            for (const std::uint32_t ant : ants) {
+                const int x = static_cast<int>(std::floor(positions[ant].getX()));
+                const int y = static_cast<int>(std::floor(positions[ant].getY()));
+                if (x >= x0 && x <= x1 && y >= y0 && y <= y1) fn(ant);
+            }
+        });
+    }
+
+    // Calls fn(antIndex) for every ant within `radius` of `center`.
+    template<typename Fn>
+    void forEachAntInRadius(const FloatPosition& center, float radius, std::span<const FloatPosition> positions, Fn&& fn) const {
+        const float radiusSquared = radius * radius;
+        forEachSpanInRect(
+            static_cast<int>(std::floor(center.getX() - radius)), static_cast<int>(std::floor(center.getY() - radius)),
+            static_cast<int>(std::floor(center.getX() + radius)), static_cast<int>(std::floor(center.getY() + radius)),
+            [&](std::span<const std::uint32_t> ants) {
+                for (const std::uint32_t ant : ants) {
+                    if (positions[ant].squaredDistanceTo(center) <= radiusSquared) fn(ant);
+                }
+            });
+    }
+
+    std::size_t countInTile(unsigned int x, unsigned int y, std::span<const FloatPosition> positions) const;
+};
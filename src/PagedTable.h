@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "AllocationCounter.h"
+
+/**
+ * @brief Fixed-size array whose storage is allocated one page at a time
+ *
+ * Entries in pages that were never written read as a value-initialized T, so
+ * a table sized for a huge world only costs one pointer per page until it is
+ * actually used. Writing through at() allocates the page on first use.
+ */
+template <typename T, unsigned int PageShift = 10>
+class PagedTable {
+public:
+    static constexpr std::size_t kPageSize = std::size_t{1} << PageShift;
+
+    explicit PagedTable(std::size_t size = 0) : size(size), pages((size + kPageSize - 1) / kPageSize) {}
+
+    std::size_t getSize() const { return size; }
+    std::size_t getAllocatedPageCount() const {
+        std::size_t count = 0;
+        for (const auto& page : pages) {
+            count += page != nullptr;
+        }
+        return count;
+    }
+
+    T get(std::size_t index) const {
+        const auto& page = pages[index >> PageShift];
+        return page ? page[index & (kPageSize - 1)] : T{};
+    }
+
+    T& at(std::size_t index) {
+        auto& page = pages[index >> PageShift];
+        if (!page) {
+            allocation_counter::LazyGrowthScope growth;
+            page = std::make_unique<T[]>(kPageSize);
+        }
+        return page[index & (kPageSize - 1)];
+    }
+
+    // Like at(index) = T{}, but never allocates a page just to store the default.
+    void reset(std::size_t index) {
+        if (auto& page = pages[index >> PageShift]) {
+            page[index & (kPageSize - 1)] = T{};
+        }
+    }
+
+private:
+    std::size_t size;
+    std::vector<std::unique_ptr<T[]>> pages;
+};
@@ -4,6 +4,9 @@
 
 enum class PheromoneType {
     FoodTrail,
+    HomeTrail,
+    Alarm,
+    Recruitment,
 };
 
-constexpr std::size_t kPheromoneTypeCount = 1;
+constexpr std::size_t kPheromoneTypeCount = 4;
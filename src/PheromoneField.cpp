@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "AllocationCounter.h"
+#include "PheromoneField.h"
+#include "ThreadPool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANTS_PHEROMONE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using DiffusionParams = PheromoneField::DiffusionParams;
+using BlockNeighborhood = PheromoneField::BlockNeighborhood;
+
+constexpr unsigned int kBlockSize = PheromoneField::kBlockSize;
+constexpr std::size_t kBlockArea = PheromoneField::kBlockArea;
+
+inline float blend(float self, float neighborSum, int neighborCount, const DiffusionParams& params) {
+    const float neighborAvg = neighborCount > 0 ? neighborSum / neighborCount : 0.0f;
+    const float blended = (self * params.selfWeight + neighborAvg * params.neighborWeight) * params.decay;
+    return blended < params.floor ? 0.0f : blended;
+}
+
+// Reference implementation, used for blocks on the world border. The SIMD
+// paths below mirror its operation order exactly.
+bool diffuseBorderBlock(const BlockNeighborhood& source, float* out, const DiffusionParams& params) {
+    std::fill(out, out + kBlockArea, 0.0f);
+    bool anyActive = false;
+    for (unsigned int r = 0; r < source.rows; ++r) {
+        for (unsigned int c = 0; c < source.columns; ++c) {
+            const float* row = source.self + r * kBlockSize;
+            float neighborSum = 0.0f;
+            int neighborCount = 0;
+            if (c > 0) {
+                neighborSum += row[c - 1]; ++neighborCount;
+            } else if (source.left) {
+                neighborSum += source.left[r * kBlockSize + kBlockSize - 1]; ++neighborCount;
+            }
+            if (c + 1 < source.columns) {
+                neighborSum += row[c + 1]; ++neighborCount;
+            } else if (source.right) {
+                neighborSum += source.right[r * kBlockSize]; ++neighborCount;
+            }
+            if (r > 0) {
+                neighborSum += (row - kBlockSize)[c]; ++neighborCount;
+            } else if (source.above) {
+                neighborSum += source.above[(kBlockSize - 1) * kBlockSize + c]; ++neighborCount;
+            }
+            if (r + 1 < source.rows) {
+                neighborSum += (row + kBlockSize)[c]; ++neighborCount;
+            } else if (source.below) {
+                neighborSum += source.below[c]; ++neighborCount;
+            }
+            const float value = blend(row[c], neighborSum, neighborCount, params);
+            out[r * kBlockSize + c] = value;
+            anyActive |= value != 0.0f;
+        }
+    }
+    return anyActive;
+}
+
+// Row r of an interior block padded with its left and right neighbours, so
+// the whole row can be processed with unaligned loads at offsets 0 and 2.
+struct alignas(64) ExtendedRow {
+    float values[kBlockSize + 8];
+};
+
+inline void extendRow(const BlockNeighborhood& source, unsigned int r, ExtendedRow& extended) {
+    extended.values[0] = source.left[r * kBlockSize + kBlockSize - 1];
+    std::memcpy(extended.values + 1, source.self + r * kBlockSize, kBlockSize * sizeof(float));
+    extended.values[kBlockSize + 1] = source.right[r * kBlockSize];
+}
+
+inline const float* rowAbove(const BlockNeighborhood& source, unsigned int r) {
+    return r > 0 ? source.self + (r - 1) * kBlockSize : source.above + (kBlockSize - 1) * kBlockSize;
+}
+
+inline const float* rowBelow(const BlockNeighborhood& source, unsigned int r) {
+    return r + 1 < kBlockSize ? source.self + (r + 1) * kBlockSize : source.below;
+}
+
+#ifdef ANTS_PHEROMONE_X86
+
+bool diffuseInteriorBlockSse(const BlockNeighborhood& source, float* out, const DiffusionParams& params) {
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 selfWeight = _mm_set1_ps(params.selfWeight);
+    const __m128 neighborWeight = _mm_set1_ps(params.neighborWeight);
+    const __m128 decay = _mm_set1_ps(params.decay);
+    const __m128 floor = _mm_set1_ps(params.floor);
+    __m128 any = _mm_setzero_ps();
+
+    ExtendedRow extended;
+    for (unsigned int r = 0; r < kBlockSize; ++r) {
+        extendRow(source, r, extended);
+        const float* above = rowAbove(source, r);
+        const float* below = rowBelow(source, r);
+        float* outRow = out + r * kBlockSize;
+        for (unsigned int c = 0; c < kBlockSize; c += 4) {
+            __m128 sum = _mm_add_ps(_mm_loadu_ps(extended.values + c), _mm_loadu_ps(extended.values + c + 2));
+            sum = _mm_add_ps(sum, _mm_load_ps(above + c));
+            sum = _mm_add_ps(sum, _mm_load_ps(below + c));
+            const __m128 self = _mm_mul_ps(_mm_loadu_ps(extended.values + c + 1), selfWeight);
+            const __m128 spread = _mm_mul_ps(_mm_mul_ps(sum, quarter), neighborWeight);
+            const __m128 blended = _mm_mul_ps(_mm_add_ps(self, spread), decay);
+            const __m128 result = _mm_and_ps(_mm_cmpge_ps(blended, floor), blended);
+            _mm_store_ps(outRow + c, result);
+            any = _mm_or_ps(any, result);
+        }
+    }
+    return _mm_movemask_ps(_mm_cmpneq_ps(any, _mm_setzero_ps())) != 0;
+}
+
+__attribute__((target("avx2")))
+bool diffuseInteriorBlockAvx2(const BlockNeighborhood& source, float* out, const DiffusionParams& params) {
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 selfWeight = _mm256_set1_ps(params.selfWeight);
+    const __m256 neighborWeight = _mm256_set1_ps(params.neighborWeight);
+    const __m256 decay = _mm256_set1_ps(params.decay);
+    const __m256 floor = _mm256_set1_ps(params.floor);
+    __m256 any = _mm256_setzero_ps();
+
+    ExtendedRow extended;
+    for (unsigned int r = 0; r < kBlockSize; ++r) {
+        extendRow(source, r, extended);
+        const float* above = rowAbove(source, r);
+        const float* below = rowBelow(source, r);
+        float* outRow = out + r * kBlockSize;
+        for (unsigned int c = 0; c < kBlockSize; c += 8) {
+            __m256 sum = _mm256_add_ps(_mm256_loadu_ps(extended.values + c), _mm256_loadu_ps(extended.values + c + 2));
+            sum = _mm256_add_ps(sum, _mm256_load_ps(above + c));
+            sum = _mm256_add_ps(sum, _mm256_load_ps(below + c));
+            const __m256 self = _mm256_mul_ps(_mm256_loadu_ps(extended.values + c + 1), selfWeight);
+            const __m256 spread = _mm256_mul_ps(_mm256_mul_ps(sum, quarter), neighborWeight);
+            const __m256 blended = _mm256_mul_ps(_mm256_add_ps(self, spread), decay);
+            const __m256 result = _mm256_and_ps(_mm256_cmp_ps(blended, floor, _CMP_GE_OQ), blended);
+            _mm256_store_ps(outRow + c, result);
+            any = _mm256_or_ps(any, result);
+        }
+    }
+    return _mm256_movemask_ps(_mm256_cmp_ps(any, _mm256_setzero_ps(), _CMP_NEQ_UQ)) != 0;
+}
+
+using InteriorKernel = bool (*)(const BlockNeighborhood&, float*, const DiffusionParams&);
+
+InteriorKernel selectInteriorKernel() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? diffuseInteriorBlockAvx2 : diffuseInteriorBlockSse;
+}
+
+#else
+
+bool diffuseInteriorBlockPortable(const BlockNeighborhood& source, float* out, const DiffusionParams& params) {
+    bool anyActive = false;
+    ExtendedRow extended;
+    for (unsigned int r = 0; r < kBlockSize; ++r) {
+        extendRow(source, r, extended);
+        const float* above = rowAbove(source, r);
+        const float* below = rowBelow(source, r);
+        for (unsigned int c = 0; c < kBlockSize; ++c) {
+            const float sum = extended.values[c] + extended.values[c + 2] + above[c] + below[c];
+            const float value = blend(extended.values[c + 1], sum, 4, params);
+            out[r * kBlockSize + c] = value;
+            anyActive |= value != 0.0f;
+        }
+    }
+    return anyActive;
+}
+
+#endif
+
+} // namespace
+
+namespace pheromone_kernels {
+
+bool diffuseBlock(const BlockNeighborhood& source, float* destination, const DiffusionParams& params) {
+    const bool interior = source.columns == kBlockSize && source.rows == kBlockSize &&
+                          source.above && source.below && source.left && source.right;
+    if (!interior) {
+        return diffuseBorderBlock(source, destination, params);
+    }
+#ifdef ANTS_PHEROMONE_X86
+    static const InteriorKernel kernel = selectInteriorKernel();
+    return kernel(source, destination, params);
+#else
+    return diffuseInteriorBlockPortable(source, destination, params);
+#endif
+}
+
+} // namespace pheromone_kernels
+
+PheromoneField::PheromoneField(unsigned int width, unsigned int height)
+    : width(width),
+      height(height),
+      blocksX((width + kBlockSize - 1) / kBlockSize),
+      blocksY((height + kBlockSize - 1) / kBlockSize),
+      queueSlot(static_cast<std::size_t>(blocksX) * blocksY) {
+    const std::size_t blockCount = static_cast<std::size_t>(blocksX) * blocksY;
+    for (auto& channel : channels) {
+        channel.current = BlockTable(blockCount);
+        channel.next = BlockTable(blockCount);
+    }
+}
+
+const float* PheromoneField::zeroBlock() {
+    alignas(64) static const float zeros[kBlockArea] = {};
+    return zeros;
+}
+
+float* PheromoneField::acquireBlock() {
+    if (freeBlocks.empty()) {
+        allocation_counter::LazyGrowthScope growth;
+        auto* data = static_cast<float*>(std::aligned_alloc(64, kBlocksPerSlab * kBlockArea * sizeof(float)));
+        if (!data) throw std::bad_alloc();
+        slabs.emplace_back(data);
+        for (std::size_t i = kBlocksPerSlab; i-- > 0;) {
+            freeBlocks.push_back(data + i * kBlockArea);
+        }
+    }
+    float* block = freeBlocks.back();
+    freeBlocks.pop_back();
+    return block;
+}
+
+template <typename T>
+void PheromoneField::reserveGrowth(std::vector<T>& list, std::size_t needed) const {
+    // Grows to twice what is needed, so a trail spreading over new ground
+    // allocates a logarithmic number of times and a trail within its
+    // previous extent not at all.
+    if (list.capacity() >= needed) return;
+    allocation_counter::LazyGrowthScope growth;
+    list.reserve(std::min(static_cast<std::size_t>(blocksX) * blocksY, 2 * needed));
+}
+
+float* PheromoneField::writableBlock(Channel& channel, std::size_t block) {
+    float*& data = channel.current.at(block);
+    if (!data) {
+        data = acquireBlock();
+        std::memset(data, 0, kBlockArea * sizeof(float));
+        reserveGrowth(channel.activeBlocks, channel.activeBlocks.size() + 1);
+        channel.activeBlocks.push_back(static_cast<std::uint32_t>(block));
+    }
+    return data;
+}
+
+void PheromoneField::deposit(unsigned int x, unsigned int y, PheromoneType type, float amount) {
+    auto& channel = channels[static_cast<std::size_t>(type)];
+    writableBlock(channel, blockIndex(x, y))[offsetInBlock(x, y)] += amount;
+    ++revision;
+}
+
+void PheromoneField::set(unsigned int x, unsigned int y, PheromoneType type, float value) {
+    auto& channel = channels[static_cast<std::size_t>(type)];
+    const std::size_t block = blockIndex(x, y);
+    if (value != 0.0f) {
+        writableBlock(channel, block)[offsetInBlock(x, y)] = value;
+    } else if (float* data = channel.current.get(block)) {
+        data[offsetInBlock(x, y)] = 0.0f;
+    }
+    ++revision;
+}
+
+void PheromoneField::setBlock(PheromoneType type, std::size_t blockIndex, const float* values) {
+    auto& channel = channels[static_cast<std::size_t>(type)];
+    std::memcpy(writableBlock(channel, blockIndex), values, kBlockArea * sizeof(float));
+    ++revision;
+}
+
+PheromoneField::BlockNeighborhood PheromoneField::neighborhood(const BlockTable& table, std::size_t block) const {
+    const unsigned int bx = static_cast<unsigned int>(block % blocksX);
+    const unsigned int by = static_cast<unsigned int>(block / blocksX);
+    auto at = [&](std::size_t b) -> const float* {
+        const float* data = table.get(b);
+        return data ? data : zeroBlock();
+    };
+    return {
+        .self = at(block),
+        .above = by > 0 ? at(block - blocksX) : nullptr,
+        .below = by + 1 < blocksY ? at(block + blocksX) : nullptr,
+        .left = bx > 0 ? at(block - 1) : nullptr,
+        .right = bx + 1 < blocksX ? at(block + 1) : nullptr,
+        .columns = std::min(kBlockSize, width - bx * kBlockSize),
+        .rows = std::min(kBlockSize, height - by * kBlockSize),
+    };
+}
+
+void PheromoneField::enqueueChannel(std::size_t type) {
+    // Visit every active block and its 4-neighbours. Any other block and its
+    // neighbours are all zero, so it would diffuse to zero anyway. Each queued
+    // block gets its destination storage up front (which also marks it as
+    // queued for this channel), so the parallel pass never touches the
+    // allocator.
+    Channel& channel = channels[type];
+    const auto bit = static_cast<std::uint8_t>(1u << type);
+    auto enqueue = [&](std::size_t block) {
+        float*& destination = channel.next.at(block);
+        if (destination) return;
+        destination = acquireBlock();
+        ++lastDiffusedBlockCount;
+        const unsigned int bx = static_cast<unsigned int>(block % blocksX);
+        const unsigned int by = static_cast<unsigned int>(block / blocksX);
+        lastDiffusedTileCount += static_cast<std::size_t>(std::min(kBlockSize, width - bx * kBlockSize)) *
+                                 std::min(kBlockSize, height - by * kBlockSize);
+        std::uint32_t& slot = queueSlot.at(block);
+        if (slot == 0) {
+            blockQueue.push_back({ static_cast<std::uint32_t>(block), 0, 0 });
+            slot = static_cast<std::uint32_t>(blockQueue.size());
+        }
+        blockQueue[slot - 1].channels |= bit;
+    };
+    for (const std::uint32_t block : channel.activeBlocks) {
+        const unsigned int bx = block % blocksX;
+        const unsigned int by = block / blocksX;
+        enqueue(block);
+        if (by > 0) enqueue(block - blocksX);
+        if (by + 1 < blocksY) enqueue(block + blocksX);
+        if (bx > 0) enqueue(block - 1);
+        if (bx + 1 < blocksX) enqueue(block + 1);
+    }
+}
+
+void PheromoneField::diffuse(const ChannelParams& params, ThreadPool* pool) {
+    static_assert(kPheromoneTypeCount <= 8, "channel masks are 8 bits wide");
+
+    // One queue for all channels, so a block needed by several of them is
+    // handed to one thread and diffused for each of them back to back.
+    lastDiffusedBlockCount = 0;
+    lastDiffusedTileCount = 0;
+    blockQueue.clear();
+
+    // Each active block brings at most itself and four neighbours, so the
+    // queue and the rebuilt active lists are sized for that before
+    // enqueueChannel() walks the lists: growing a list while it is walked
+    // would invalidate the walk.
+    const std::size_t totalBlocks = static_cast<std::size_t>(blocksX) * blocksY;
+    std::size_t maxQueued = 0;
+    for (auto& channel : channels) {
+        const std::size_t maxBlocks = std::min(totalBlocks, 5 * channel.activeBlocks.size());
+        reserveGrowth(channel.activeBlocks, maxBlocks);
+        maxQueued += maxBlocks;
+    }
+    reserveGrowth(blockQueue, std::min(totalBlocks, maxQueued));
+    for (std::size_t type = 0; type < kPheromoneTypeCount; ++type) {
+        enqueueChannel(type);
+    }
+    ++revision;
+    if (blockQueue.empty()) return;
+
+    auto diffuseQueued = [&](std::size_t begin, std::size_t end, unsigned int) {
+        for (std::size_t i = begin; i < end; ++i) {
+            QueuedBlock& queued = blockQueue[i];
+            for (std::size_t type = 0; type < kPheromoneTypeCount; ++type) {
+                if (!(queued.channels & (1u << type))) continue;
+                const Channel& channel = channels[type];
+                if (pheromone_kernels::diffuseBlock(neighborhood(channel.current, queued.block),
+                                                    channel.next.get(queued.block), params[type])) {
+                    queued.resultActive |= static_cast<std::uint8_t>(1u << type);
+                }
+            }
+        }
+    };
+    static constexpr std::size_t kBlocksPerChunk = 4;
+    if (pool) {
+        pool->parallelFor(blockQueue.size(), kBlocksPerChunk, diffuseQueued);
+    } else {
+        diffuseQueued(0, blockQueue.size(), 0);
+    }
+
+    // Rebuild the active lists. Source blocks are no longer needed; results
+    // that came out all zero are released instead of becoming current.
+    for (auto& channel : channels) {
+        channel.activeBlocks.clear();
+    }
+    for (const QueuedBlock& queued : blockQueue) {
+        const std::size_t block = queued.block;
+        queueSlot.reset(block);
+        for (std::size_t type = 0; type < kPheromoneTypeCount; ++type) {
+            if (!(queued.channels & (1u << type))) continue;
+            Channel& channel = channels[type];
+            if (float* previous = channel.current.get(block)) {
+                releaseBlock(previous);
+            }
+            float* result = channel.next.get(block);
+            channel.next.reset(block);
+            if (queued.resultActive & (1u << type)) {
+                channel.current.at(block) = result;
+                channel.activeBlocks.push_back(static_cast<std::uint32_t>(block));
+            } else {
+                channel.current.reset(block);
+                releaseBlock(result);
+            }
+        }
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "PagedTable.h"
+#include "Pheromone.h"
+
+class ThreadPool;
+
+/**
+ * @brief Pheromone concentrations stored as one float plane per PheromoneType
+ *
+ * Planes are tiled into kBlockSize x kBlockSize blocks; each block is a
+ * contiguous, 64-byte aligned run of floats in row-major order. Each plane
+ * is double buffered: diffuse() reads the current buffer, writes the next
+ * one and then swaps the two by pointer.
+ *
+ * Only blocks holding pheromone are kept on an active list. A diffusion step
+ * visits active blocks plus their 4-neighbour halo and skips the rest, so its
+ * cost follows the trail area rather than the world area. Blocks that decay
+ * to all-zero drop off the list.
+ *
+ * All planes advance in one pass over a shared block queue: a block is
+ * queued once, with a mask of the channels that need it. The planes are not
+ * interleaved, though, so the kernel still reads each channel's neighbourhood
+ * of a queued block separately. Channels are sparse independently of each
+ * other (a food trail rarely overlaps a home trail), and interleaving them
+ * would give every stored block room and bandwidth for all channels, most of
+ * them zero. Separate planes keep a channel with no active blocks free of
+ * work, memory and memory traffic.
+ *
+ * Block storage is allocated lazily as well: a block that is not active has
+ * no storage in either buffer and reads as zero, so memory follows the trail
+ * area too. Freed blocks go back to a free list and are reused, so a trail
+ * that stays within the area it has covered before does not allocate.
+ */
+class PheromoneField {
+public:
+    static constexpr unsigned int kBlockShift = 5;
+    static constexpr unsigned int kBlockSize = 1u << kBlockShift;
+    static constexpr std::size_t kBlockArea = static_cast<std::size_t>(kBlockSize) * kBlockSize;
+
+    struct DiffusionParams {
+        float selfWeight;
+        float neighborWeight;
+        float decay;
+        float floor;
+    };
+
+    /**
+     * @brief Source data needed to diffuse one block
+     *
+     * Neighbour pointers refer to whole blocks and are null where the block
+     * would lie outside the world. `columns`/`rows` give the part of the block
+     * inside the world; only the last block column/row can be partial.
+     */
+    struct BlockNeighborhood {
+        const float* self;
+        const float* above;
+        const float* below;
+        const float* left;
+        const float* right;
+        unsigned int columns;
+        unsigned int rows;
+    };
+
+private:
+    struct AlignedFree {
+        void operator()(float* data) const { std::free(data); }
+    };
+    using Slab = std::unique_ptr<float[], AlignedFree>;
+    static constexpr std::size_t kBlocksPerSlab = 64;
+
+    // Block index -> kBlockArea floats; null means the block is all zero.
+    // Between diffusion steps every `next` entry is null.
+    using BlockTable = PagedTable<float*>;
+
+    struct Channel {
+        BlockTable current;
+        BlockTable next;
+        std::vector<std::uint32_t> activeBlocks;
+    };
+
+    unsigned int width;
+    unsigned int height;
+    unsigned int blocksX;
+    unsigned int blocksY;
+    std::array<Channel, kPheromoneTypeCount> channels;
+
+    std::vector<Slab> slabs;
+    std::vector<float*> freeBlocks;
+    std::uint64_t revision = 0;
+    std::size_t lastDiffusedBlockCount = 0;
+    std::size_t lastDiffusedTileCount = 0;
+
+    // A block to diffuse, with bit masks over PheromoneType: the channels
+    // it is diffused for and those whose result came out non-zero.
+    struct QueuedBlock {
+        std::uint32_t block;
+        std::uint8_t channels;
+        std::uint8_t resultActive;
+    };
+
+    // Reused by every diffuse() so steady-state ticks do not allocate.
+    // queueSlot maps a queued block to its queue entry + 1.
+    std::vector<QueuedBlock> blockQueue;
+    PagedTable<std::uint32_t> queueSlot;
+
+    static const float* zeroBlock();
+    float* acquireBlock();
+    // Reserves room for `needed` entries ahead of a push, counted as lazy
+    // growth.
+    template <typename T>
+    void reserveGrowth(std::vector<T>& list, std::size_t needed) const;
+    void releaseBlock(float* block) { freeBlocks.push_back(block); }
+    std::size_t blockIndex(unsigned int x, unsigned int y) const {
+        return static_cast<std::size_t>(y >> kBlockShift) * blocksX + (x >> kBlockShift);
+    }
+    static std::size_t offsetInBlock(unsigned int x, unsigned int y) {
+        return ((y & (kBlockSize - 1)) << kBlockShift) | (x & (kBlockSize - 1));
+    }
+    float* writableBlock(Channel& channel, std::size_t block);
+    BlockNeighborhood neighborhood(const BlockTable& table, std::size_t block) const;
+    void enqueueChannel(std::size_t type);
+
+public:
+    PheromoneField(unsigned int width, unsigned int height);
+
+    unsigned int getWidth() const { return width; }
+    unsigned int getHeight() const { return height; }
+    unsigned int getBlocksX() const { return blocksX; }
+    unsigned int getBlocksY() const { return blocksY; }
+
+    float get(unsigned int x, unsigned int y, PheromoneType type) const {
+        const float* data = channels[static_cast<std::size_t>(type)].current.get(blockIndex(x, y));
+        return data ? data[offsetInBlock(x, y)] : 0.0f;
+    }
+    void deposit(unsigned int x, unsigned int y, PheromoneType type, float amount);
+    void set(unsigned int x, unsigned int y, PheromoneType type, float value);
+    // Overwrites a whole block with kBlockArea floats, e.g. from a snapshot.
+    void setBlock(PheromoneType type, std::size_t blockIndex, const float* values);
+
+    // Blocks of `type` that may hold non-zero values, in no particular order.
+    const std::vector<std::uint32_t>& getActiveBlocks(PheromoneType type) const {
+        return channels[static_cast<std::size_t>(type)].activeBlocks;
+    }
+    // kBlockArea floats, row-major within the block. Blocks without storage
+    // return a shared all-zero block.
+    const float* block(PheromoneType type, std::size_t blockIndex) const {
+        const float* data = channels[static_cast<std::size_t>(type)].current.get(blockIndex);
+        return data ? data : zeroBlock();
+    }
+    // The block of `type` and its neighbours, as read by diffusion.
+    BlockNeighborhood getNeighborhood(PheromoneType type, std::size_t blockIndex) const {
+        return neighborhood(channels[static_cast<std::size_t>(type)].current, blockIndex);
+    }
+    // Changes whenever any value may have changed, so views can skip
+    // re-reading a field that is still the same.
+    std::uint64_t getRevision() const { return revision; }
+    // Blocks the last diffuse() visited, over all channels.
+    std::size_t getLastDiffusedBlockCount() const { return lastDiffusedBlockCount; }
+    // In-world tiles of those blocks; partial blocks on the world border
+    // count only the part inside the world.
+    std::size_t getLastDiffusedTileCount() const { return lastDiffusedTileCount; }
+    // Blocks currently backed by storage, over all channels and both buffers.
+    std::size_t getAllocatedBlockCount() const { return slabs.size() * kBlocksPerSlab - freeBlocks.size(); }
+
+    using ChannelParams = std::array<DiffusionParams, kPheromoneTypeCount>;
+
+    /**
+     * @brief Advances every plane by one diffusion + decay step
+     *
+     * The next value of a tile blends its own value with the average of its
+     * in-bounds 4-neighbours, scales by the decay factor and snaps values
+     * below the floor to zero, using the parameters of its plane's type.
+     *
+     * With a pool, the blocks to visit are spread over the threads. Blocks
+     * read their halo from the previous buffer, so no locking is needed and
+     * the result is bit-identical to the serial pass.
+     */
+    void diffuse(const ChannelParams& params, ThreadPool* pool = nullptr);
+};
+
+namespace pheromone_kernels {
+
+/**
+ * @brief Runs one diffusion step for a single block
+ *
+ * Writes kBlockArea floats to `destination` (tiles outside the world stay
+ * zero) and returns whether any written value is non-zero. Blocks fully
+ * inside the world with all four neighbours use the widest SIMD path the CPU
+ * supports; blocks on the world border go through the scalar path. Every
+ * path performs the same float operations in the same order, so results are
+ * bit-identical.
+ */
+bool diffuseBlock(const PheromoneField::BlockNeighborhood& source, float* destination,
+                  const PheromoneField::DiffusionParams& params);
+
+} // namespace pheromone_kernels
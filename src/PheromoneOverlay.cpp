@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "PheromoneOverlay.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANTS_OVERLAY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using ColorMap = PheromoneOverlay::ColorMap;
+
+constexpr unsigned int kBlockShift = PheromoneField::kBlockShift;
+constexpr unsigned int kBlockSize = PheromoneField::kBlockSize;
+// Pixels are R, G, B, A in memory order.
+constexpr unsigned int kAlphaShift = std::endian::native == std::endian::little ? 24 : 0;
+
+std::uint32_t basePixel(const ColorMap& colorMap) {
+    const std::uint8_t bytes[4] = { colorMap.red, colorMap.green, colorMap.blue, 0 };
+    std::uint32_t pixel;
+    std::memcpy(&pixel, bytes, sizeof(pixel));
+    return pixel;
+}
+
+void colorMapRowScalar(const float* values, std::size_t count, std::uint32_t base, const ColorMap& colorMap,
+                       std::uint32_t* out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const float alpha = std::max(std::min(values[i] * colorMap.alphaPerUnit, colorMap.maxAlpha), 0.0f);
+        out[i] = base | (static_cast<std::uint32_t>(alpha) << kAlphaShift);
+    }
+}
+
+// Four pixels per step with SSE2; the same clamp and truncation as the
+// scalar loop, which handles the tail.
+void colorMapRow(const float* values, std::size_t count, std::uint32_t base, const ColorMap& colorMap,
+                 std::uint32_t* out) {
+    std::size_t i = 0;
+#ifdef ANTS_OVERLAY_X86
+    const __m128 scale = _mm_set1_ps(colorMap.alphaPerUnit);
+    const __m128 maxAlpha = _mm_set1_ps(colorMap.maxAlpha);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i basePixels = _mm_set1_epi32(static_cast<int>(base));
+    for (; i + 4 <= count; i += 4) {
+        const __m128 alpha = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(values + i), scale), maxAlpha), zero);
+        const __m128i alphaBits = _mm_slli_epi32(_mm_cvttps_epi32(alpha), kAlphaShift);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(basePixels, alphaBits));
+    }
+#endif
+    colorMapRowScalar(values + i, count - i, base, colorMap, out + i);
+}
+
+} // namespace
+
+PheromoneOverlay::PheromoneOverlay(unsigned int width, unsigned int height, PheromoneType type,
+                                   const ColorMap& colorMap)
+    : width(width),
+      height(height),
+      type(type),
+      colorMap{ colorMap.red, colorMap.green, colorMap.blue, colorMap.alphaPerUnit,
+                std::clamp(colorMap.maxAlpha, 0.0f, 255.0f) },
+      pixels(static_cast<std::size_t>(width) * height, basePixel(colorMap)),
+      blockStamps(static_cast<std::size_t>((width + kBlockSize - 1) / kBlockSize) *
+                  ((height + kBlockSize - 1) / kBlockSize), 0) {
+}
+
+bool PheromoneOverlay::update(const PheromoneField& field) {
+    dirtyRowBegin = dirtyRowEnd = 0;
+    if (field.getWidth() != width || field.getHeight() != height) {
+        throw std::invalid_argument("pheromone field size does not match the overlay");
+    }
+    if (painted && &field == lastSource && field.getRevision() == lastRevision) {
+        return false;
+    }
+    lastSource = &field;
+    lastRevision = field.getRevision();
+    return repaint(field.getActiveBlocks(type), [&](std::size_t, std::uint32_t block) {
+        return field.block(type, block);
+    });
+}
+
+bool PheromoneOverlay::update(std::span<const std::uint32_t> blocks, const float* values, std::uint64_t revision) {
+    dirtyRowBegin = dirtyRowEnd = 0;
+    if (painted && lastSource == nullptr && revision == lastRevision) {
+        return false;
+    }
+    lastSource = nullptr;
+    lastRevision = revision;
+    return repaint(blocks, [values](std::size_t i, std::uint32_t) {
+        return values + i * PheromoneField::kBlockArea;
+    });
+}
+
+template <typename BlockValues>
+bool PheromoneOverlay::repaint(std::span<const std::uint32_t> blocks, BlockValues&& valuesOf) {
+    alignas(64) static const float zeros[PheromoneField::kBlockArea] = {};
+    painted = true;
+    ++stamp;
+
+    unsigned int rowBegin = height;
+    unsigned int rowEnd = 0;
+    auto paint = [&](std::uint32_t block, const float* values) {
+        paintBlock(block, values);
+        const unsigned int firstRow = (block / blocksX()) << kBlockShift;
+        rowBegin = std::min(rowBegin, firstRow);
+        rowEnd = std::max(rowEnd, std::min(height, firstRow + kBlockSize));
+    };
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        paint(blocks[i], valuesOf(i, blocks[i]));
+        blockStamps[blocks[i]] = stamp;
+    }
+    // Blocks painted last time that are no longer listed read as zero now.
+    for (const std::uint32_t block : paintedBlocks) {
+        if (blockStamps[block] != stamp) {
+            paint(block, zeros);
+        }
+    }
+    paintedBlocks.assign(blocks.begin(), blocks.end());
+
+    if (rowBegin < rowEnd) {
+        dirtyRowBegin = rowBegin;
+        dirtyRowEnd = rowEnd;
+    }
+    return dirtyRowBegin < dirtyRowEnd;
+}
+
+void PheromoneOverlay::paintBlock(std::uint32_t block, const float* values) {
+    const unsigned int x0 = (block % blocksX()) << kBlockShift;
+    const unsigned int y0 = (block / blocksX()) << kBlockShift;
+    const unsigned int columns = std::min(kBlockSize, width - x0);
+    const unsigned int rows = std::min(kBlockSize, height - y0);
+    const std::uint32_t base = basePixel(colorMap);
+    for (unsigned int row = 0; row < rows; ++row) {
+        colorMapRow(values + (static_cast<std::size_t>(row) << kBlockShift), columns, base, colorMap,
+                    pixels.data() + static_cast<std::size_t>(y0 + row) * width + x0);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Pheromone.h"
+#include "PheromoneField.h"
+
+/**
+ * @brief RGBA8 image of one pheromone plane, updated incrementally
+ *
+ * One pixel per tile, row-major, ready to upload as a texture. Each pixel is
+ * the colour map's RGB with an alpha proportional to the concentration.
+ *
+ * update() only repaints blocks that are active now or were painted last
+ * time (to clear them), and reports the band of rows it touched, so the
+ * upload can skip the rest. A field whose revision has not changed since the
+ * last update is not read at all.
+ */
+class PheromoneOverlay {
+public:
+    struct ColorMap {
+        std::uint8_t red;
+        std::uint8_t green;
+        std::uint8_t blue;
+        float alphaPerUnit; // alpha = min(maxAlpha, concentration * alphaPerUnit)
+        float maxAlpha;
+    };
+
+    PheromoneOverlay(unsigned int width, unsigned int height, PheromoneType type, const ColorMap& colorMap);
+
+    // Returns whether any pixel may have changed.
+    bool update(const PheromoneField& field);
+    // Same, from a copy of the plane: the listed blocks, each followed by its
+    // kBlockArea floats in `values`, and the revision of the field it was
+    // copied from.
+    bool update(std::span<const std::uint32_t> blocks, const float* values, std::uint64_t revision);
+
+    unsigned int getWidth() const { return width; }
+    unsigned int getHeight() const { return height; }
+    // width * height * 4 bytes.
+    const std::uint8_t* getPixels() const { return reinterpret_cast<const std::uint8_t*>(pixels.data()); }
+    // Rows [begin, end) touched by the last update().
+    unsigned int getDirtyRowBegin() const { return dirtyRowBegin; }
+    unsigned int getDirtyRowEnd() const { return dirtyRowEnd; }
+
+private:
+    const unsigned int width;
+    const unsigned int height;
+    const PheromoneType type;
+    const ColorMap colorMap;
+
+    std::vector<std::uint32_t> pixels;
+    std::vector<std::uint32_t> paintedBlocks;
+    std::vector<std::uint32_t> blockStamps; // update number that last painted each block
+    std::uint32_t stamp = 0;
+    const void* lastSource = nullptr; // the field, or null for copies
+    std::uint64_t lastRevision = 0;
+    bool painted = false;
+    unsigned int dirtyRowBegin = 0;
+    unsigned int dirtyRowEnd = 0;
+
+    unsigned int blocksX() const { return (width + PheromoneField::kBlockSize - 1) / PheromoneField::kBlockSize; }
+    template <typename BlockValues>
+    bool repaint(std::span<const std::uint32_t> blocks, BlockValues&& valuesOf);
+    void paintBlock(std::uint32_t block, const float* values);
+};
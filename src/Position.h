@@ -1,221 +1,225 @@
 #pragma once
 
-#include <string>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
 #include "Vector2D.h"
 
 // Forward declarations
 class IntegerPosition;
 class FloatPosition;
 
-/**
- * @brief Base position class with common functionality
- */
-class Position {
-public:
-    virtual ~Position() = default;
-    
-    // Common interface for all position types
-    virtual float getX() const = 0;
-    virtual float getY() const = 0;
-    
-    // Shared implementation for distance calculation
-    template<typename PositionType>
-    float calculateDistance(const PositionType& other) const {
-        float dx = getX() - other.getX();
-        float dy = getY() - other.getY();
-        return std::sqrt(dx * dx + dy * dy);
-    }
-    
-    template<typename PositionType>
-    float calculateSquaredDistance(const PositionType& other) const {
-        float dx = getX() - other.getX();
-        float dy = getY() - other.getY();
-        return dx * dx + dy * dy;
-    }
-    
-    // String representation
-    virtual std::string toString() const {
-        return "(" + std::to_string(getX()) + "," + std::to_string(getY()) + ")";
-    }
-};
-
 /**
  * @brief Represents a position in the world using integer X,Y coordinates
+ *
+ * A plain 8-byte value: no virtual functions, trivially copyable, and all
+ * arithmetic that does not need a square root is constexpr.
  */
-class IntegerPosition : public Position {
+class IntegerPosition {
 private:
     unsigned int x;
     unsigned int y;
 
 public:
-    IntegerPosition(unsigned int x = 0, unsigned int y = 0) : x(x), y(y) {}
-    IntegerPosition(const FloatPosition& pos);
-    
-    // Implementation of the Position interface
-    float getX() const override { return static_cast<float>(x); }
-    float getY() const override { return static_cast<float>(y); }
-    
+    constexpr IntegerPosition(unsigned int x = 0, unsigned int y = 0) : x(x), y(y) {}
+    constexpr IntegerPosition(const FloatPosition& pos);
+
+    constexpr float getX() const { return static_cast<float>(x); }
+    constexpr float getY() const { return static_cast<float>(y); }
+
     // Integer-specific getters
-    unsigned int getIntX() const { return x; }
-    unsigned int getIntY() const { return y; }
-    
-    // Distance methods using the base class implementation
+    constexpr unsigned int getIntX() const { return x; }
+    constexpr unsigned int getIntY() const { return y; }
+
     float distanceTo(const IntegerPosition& other) const {
-        return calculateDistance(other);
+        return std::sqrt(squaredDistanceTo(other));
     }
-    
-    float distanceTo(const FloatPosition& other) const {
-        return calculateDistance(other);
-    }
-    
-    float squaredDistanceTo(const IntegerPosition& other) const {
-        return calculateSquaredDistance(other);
-    }
-    
-    float squaredDistanceTo(const FloatPosition& other) const {
-        return calculateSquaredDistance(other);
-    }
-    
-    // Assignment operator
-    IntegerPosition& operator=(const IntegerPosition& other) {
-        if (this != &other) {
-            x = other.x;
-            y = other.y;
-        }
-        return *this;
-    }
-    
-    // Equality operator for comparison
-    bool operator==(const IntegerPosition& other) const {
-        return x == other.x && y == other.y;
-    }
-    
+
+    float distanceTo(const FloatPosition& other) const;
+
+    // Exact in integers; only the result is converted.
+    constexpr float squaredDistanceTo(const IntegerPosition& other) const {
+        const std::int64_t dx = static_cast<std::int64_t>(x) - other.x;
+        const std::int64_t dy = static_cast<std::int64_t>(y) - other.y;
+        return static_cast<float>(dx * dx + dy * dy);
+    }
+
+    constexpr float squaredDistanceTo(const FloatPosition& other) const;
+
+    constexpr bool operator==(const IntegerPosition& other) const = default;
+
     // Addition operator for IntegerPosition
-    IntegerPosition operator+(const IntegerPosition& other) const {
+    constexpr IntegerPosition operator+(const IntegerPosition& other) const {
         return IntegerPosition(x + other.x, y + other.y);
     }
-    
+
     // Addition operator with FloatPosition (returns FloatPosition)
-    FloatPosition operator+(const FloatPosition& other) const;
-    
+    constexpr FloatPosition operator+(const FloatPosition& other) const;
+
     // Subtraction operator for IntegerPosition
-    IntegerPosition operator-(const IntegerPosition& other) const {
+    constexpr IntegerPosition operator-(const IntegerPosition& other) const {
         return IntegerPosition(x - other.x, y - other.y);
     }
-    
+
     // Subtraction operator with FloatPosition (returns FloatPosition)
-    FloatPosition operator-(const FloatPosition& other) const;
-    
-    // Custom string representation
-    std::string toString() const override {
-        return "Int" + Position::toString();
+    constexpr FloatPosition operator-(const FloatPosition& other) const;
+
+    std::string toString() const {
+        return "Int(" + std::to_string(getX()) + "," + std::to_string(getY()) + ")";
     }
 };
 
 /**
  * @brief Represents a position in the world using float X,Y coordinates
+ *
+ * Same layout as a Vector2D: two floats, trivially copyable.
  */
-class FloatPosition : public Position {
+class FloatPosition {
 private:
     Vector2D vector;
-    
+
 public:
-    FloatPosition() : vector() {}
-    FloatPosition(float x, float y) : vector(x, y) {}
-    FloatPosition(const Vector2D& v) : vector(v) {}
-    FloatPosition(const IntegerPosition& pos) : vector(pos.getX(), pos.getY()) {}
-    
-    // Implementation of the Position interface
-    float getX() const override { return vector.x; }
-    float getY() const override { return vector.y; }
-    
+    constexpr FloatPosition() : vector() {}
+    constexpr FloatPosition(float x, float y) : vector(x, y) {}
+    constexpr FloatPosition(const Vector2D& v) : vector(v) {}
+    constexpr FloatPosition(const IntegerPosition& pos) : vector(pos.getX(), pos.getY()) {}
+
+    constexpr float getX() const { return vector.x; }
+    constexpr float getY() const { return vector.y; }
+
     // Get the underlying Vector2D
-    Vector2D toVector2D() const { return vector; }
-    
-    // Distance methods using the base class implementation
+    constexpr Vector2D toVector2D() const { return vector; }
+
     float distanceTo(const FloatPosition& other) const {
-        return calculateDistance(other);
+        return std::sqrt(squaredDistanceTo(other));
     }
-    
+
     float distanceTo(const IntegerPosition& other) const {
-        return calculateDistance(other);
-    }
-    
-    float squaredDistanceTo(const FloatPosition& other) const {
-        return calculateSquaredDistance(other);
+        return std::sqrt(squaredDistanceTo(other));
     }
-    
-    float squaredDistanceTo(const IntegerPosition& other) const {
-        return calculateSquaredDistance(other);
+
+    constexpr float squaredDistanceTo(const FloatPosition& other) const {
+        const float dx = vector.x - other.vector.x;
+        const float dy = vector.y - other.vector.y;
+        return dx * dx + dy * dy;
     }
-    
-    // Assignment operator
-    FloatPosition& operator=(const FloatPosition& other) {
-        if (this != &other) {
-            vector = other.vector;
-        }
-        return *this;
+
+    constexpr float squaredDistanceTo(const IntegerPosition& other) const {
+        return squaredDistanceTo(FloatPosition(other));
     }
 
-    // Equality operator
-    bool operator==(const FloatPosition& other) const {
+    constexpr bool operator==(const FloatPosition& other) const {
         return vector.x == other.vector.x && vector.y == other.vector.y;
     }
-    
-    bool operator==(const IntegerPosition& other) const {
+
+    constexpr bool operator==(const IntegerPosition& other) const {
         return vector.x == other.getX() && vector.y == other.getY();
     }
-    
+
     // Addition operator for FloatPosition
-    FloatPosition operator+(const FloatPosition& other) const {
+    constexpr FloatPosition operator+(const FloatPosition& other) const {
         return FloatPosition(vector.x + other.vector.x, vector.y + other.vector.y);
     }
-    
+
     // Addition operator with IntegerPosition
-    FloatPosition operator+(const IntegerPosition& other) const {
+    constexpr FloatPosition operator+(const IntegerPosition& other) const {
         return FloatPosition(vector.x + other.getX(), vector.y + other.getY());
     }
-    
+
     // Addition with Vector2D
-    FloatPosition operator+(const Vector2D& v) const {
+    constexpr FloatPosition operator+(const Vector2D& v) const {
         return FloatPosition(vector.x + v.x, vector.y + v.y);
     }
-    
+
     // Subtraction operator for FloatPosition
-    FloatPosition operator-(const FloatPosition& other) const {
+    constexpr FloatPosition operator-(const FloatPosition& other) const {
         return FloatPosition(vector.x - other.vector.x, vector.y - other.vector.y);
     }
-    
+
     // Subtraction operator with IntegerPosition
-    FloatPosition operator-(const IntegerPosition& other) const {
+    constexpr FloatPosition operator-(const IntegerPosition& other) const {
         return FloatPosition(vector.x - other.getX(), vector.y - other.getY());
     }
-    
+
     // Subtraction that returns Vector2D
-    Vector2D toVector(const FloatPosition& other) const {
+    constexpr Vector2D toVector(const FloatPosition& other) const {
         return Vector2D(vector.x - other.vector.x, vector.y - other.vector.y);
     }
 
-    // Custom string representation
-    std::string toString() const override {
-        return "Float" + Position::toString();
+    std::string toString() const {
+        return "Float(" + std::to_string(getX()) + "," + std::to_string(getY()) + ")";
     }
 
     IntegerPosition toIntegerPosition() const {
         unsigned int intX = static_cast<unsigned int>(std::floor(vector.x));
         unsigned int intY = static_cast<unsigned int>(std::floor(vector.y));
-        
+
         return IntegerPosition(intX, intY);
     }
 };
 
-inline FloatPosition IntegerPosition::operator+(const FloatPosition& other) const {
+static_assert(sizeof(IntegerPosition) == 8 && std::is_trivially_copyable_v<IntegerPosition>);
+static_assert(sizeof(FloatPosition) == 8 && std::is_trivially_copyable_v<FloatPosition>);
+
+inline float IntegerPosition::distanceTo(const FloatPosition& other) const {
+    return other.distanceTo(*this);
+}
+
+constexpr float IntegerPosition::squaredDistanceTo(const FloatPosition& other) const {
+    return other.squaredDistanceTo(*this);
+}
+
+constexpr FloatPosition IntegerPosition::operator+(const FloatPosition& other) const {
     return FloatPosition(x + other.getX(), y + other.getY());
 }
 
-inline FloatPosition IntegerPosition::operator-(const FloatPosition& other) const {
+constexpr FloatPosition IntegerPosition::operator-(const FloatPosition& other) const {
     return FloatPosition(x - other.getX(), y - other.getY());
 }
 
-inline IntegerPosition::IntegerPosition(const FloatPosition& pos) : x(pos.getX()), y(pos.getY()) {}
+// Truncates toward zero, which for the non-negative positions of the world is
+// the tile the position lies in.
+constexpr IntegerPosition::IntegerPosition(const FloatPosition& pos)
+    : x(static_cast<unsigned int>(pos.getX())), y(static_cast<unsigned int>(pos.getY())) {}
+
+/**
+ * @brief Batch helpers over spans of positions and vectors
+ *
+ * Plain loops over 8-byte values with no calls or branches the compiler
+ * cannot if-convert, so they vectorize. Results match the scalar member
+ * functions element for element.
+ */
+namespace position_kernels {
+
+inline void squaredDistances(std::span<const FloatPosition> positions, const FloatPosition& target,
+                             std::span<float> out) {
+    assert(out.size() >= positions.size());
+    const float tx = target.getX();
+    const float ty = target.getY();
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        const float dx = positions[i].getX() - tx;
+        const float dy = positions[i].getY() - ty;
+        out[i] = dx * dx + dy * dy;
+    }
+}
+
+inline void distances(std::span<const FloatPosition> positions, const FloatPosition& target, std::span<float> out) {
+    squaredDistances(positions, target, out);
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        out[i] = std::sqrt(out[i]);
+    }
+}
+
+// In place; vectors shorter than Vector2D::kNormalizeEpsilon become zero,
+// as with Vector2D::normalized().
+inline void normalize(std::span<Vector2D> vectors) {
+    for (Vector2D& v : vectors) {
+        const float magnitude = std::sqrt(v.x * v.x + v.y * v.y);
+        v = magnitude < Vector2D::kNormalizeEpsilon ? Vector2D() : Vector2D(v.x / magnitude, v.y / magnitude);
+    }
+}
+
+} // namespace position_kernels
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Profiler.h"
+
+namespace {
+
+constexpr unsigned int kSubBucketBits = 4;
+constexpr std::uint64_t kSubBucketCount = 1u << kSubBucketBits;
+constexpr std::uint64_t kMaxNanoseconds = (std::uint64_t{1} << 40) - 1;
+
+std::size_t bucketFor(std::uint64_t nanoseconds) {
+    nanoseconds = std::min(nanoseconds, kMaxNanoseconds);
+    if (nanoseconds < kSubBucketCount) return static_cast<std::size_t>(nanoseconds);
+    const unsigned int exponent = static_cast<unsigned int>(std::bit_width(nanoseconds)) - 1;
+    const std::uint64_t subBucket = (nanoseconds >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+    return static_cast<std::size_t>((exponent - kSubBucketBits + 1) * kSubBucketCount + subBucket);
+}
+
+// Lower bound and width of a bucket, in nanoseconds.
+std::uint64_t bucketLowerBound(std::size_t bucket) {
+    if (bucket < kSubBucketCount) return bucket;
+    const unsigned int exponent = static_cast<unsigned int>(bucket / kSubBucketCount) + kSubBucketBits - 1;
+    return (kSubBucketCount + bucket % kSubBucketCount) << (exponent - kSubBucketBits);
+}
+
+std::uint64_t bucketWidth(std::size_t bucket) {
+    if (bucket < kSubBucketCount) return 1;
+    const unsigned int exponent = static_cast<unsigned int>(bucket / kSubBucketCount) + kSubBucketBits - 1;
+    return std::uint64_t{1} << (exponent - kSubBucketBits);
+}
+
+// Written only by the owning thread, read by collect() from any thread.
+struct ThreadHistograms {
+    struct Phase {
+        std::array<std::atomic<std::uint64_t>, profiler::kBucketCount> counts{};
+        std::atomic<std::uint64_t> totalNanoseconds{0};
+    };
+    std::array<Phase, kProfilePhaseCount> phases;
+};
+
+void bump(std::atomic<std::uint64_t>& value, std::uint64_t amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+std::atomic<bool> enabled{false};
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadHistograms>> registry;
+thread_local ThreadHistograms* threadHistograms = nullptr;
+
+ThreadHistograms& localHistograms() {
+    if (!threadHistograms) {
+        std::lock_guard lock(registryMutex);
+        registry.push_back(std::make_unique<ThreadHistograms>());
+        threadHistograms = registry.back().get();
+    }
+    return *threadHistograms;
+}
+
+} // namespace
+
+const char* profilePhaseName(ProfilePhase phase) {
+    switch (phase) {
+        case ProfilePhase::Tick:               return "tick";
+        case ProfilePhase::Sensing:            return "sensing";
+        case ProfilePhase::Decide:             return "decide";
+        case ProfilePhase::ApplyActions:       return "apply actions";
+        case ProfilePhase::Move:               return "move";
+        case ProfilePhase::PheromoneDiffusion: return "pheromone diffusion";
+        case ProfilePhase::RenderTerrain:      return "render terrain";
+        case ProfilePhase::RenderOverlay:      return "render overlay";
+        case ProfilePhase::RenderFood:         return "render food";
+        case ProfilePhase::RenderAnts:         return "render ants";
+        case ProfilePhase::Present:            return "present";
+    }
+    return "unknown";
+}
+
+namespace profiler {
+
+double Histogram::percentile(double q) const {
+    if (count == 0) return 0.0;
+    const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(count);
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+        if (counts[bucket] == 0) continue;
+        seen += counts[bucket];
+        if (static_cast<double>(seen) >= rank) {
+            return static_cast<double>(bucketLowerBound(bucket)) + static_cast<double>(bucketWidth(bucket)) / 2.0;
+        }
+    }
+    return static_cast<double>(kMaxNanoseconds);
+}
+
+Histogram& Histogram::operator-=(const Histogram& other) {
+    for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+        counts[bucket] -= other.counts[bucket];
+    }
+    count -= other.count;
+    totalNanoseconds -= other.totalNanoseconds;
+    return *this;
+}
+
+void setEnabled(bool enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void record(ProfilePhase phase, std::uint64_t nanoseconds) {
+    auto& histograms = localHistograms().phases[static_cast<std::size_t>(phase)];
+    bump(histograms.counts[bucketFor(nanoseconds)], 1);
+    bump(histograms.totalNanoseconds, nanoseconds);
+}
+
+PhaseHistograms collect() {
+    PhaseHistograms result;
+    std::lock_guard lock(registryMutex);
+    for (const auto& thread : registry) {
+        for (std::size_t p = 0; p < kProfilePhaseCount; ++p) {
+            Histogram& histogram = result[p];
+            const auto& source = thread->phases[p];
+            for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+                const std::uint64_t n = source.counts[bucket].load(std::memory_order_relaxed);
+                histogram.counts[bucket] += n;
+                histogram.count += n;
+            }
+            histogram.totalNanoseconds += source.totalNanoseconds.load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+void writeReport(std::ostream& out, const PhaseHistograms& histograms) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-20s %10s %12s %10s %10s %10s %10s\n",
+                  "phase", "samples", "total ms", "mean us", "p50 us", "p90 us", "p99 us");
+    out << line;
+    for (std::size_t p = 0; p < kProfilePhaseCount; ++p) {
+        const Histogram& histogram = histograms[p];
+        if (histogram.count == 0) continue;
+        const double mean = static_cast<double>(histogram.totalNanoseconds) / static_cast<double>(histogram.count);
+        std::snprintf(line, sizeof(line), "%-20s %10llu %12.3f %10.3f %10.3f %10.3f %10.3f\n",
+                      profilePhaseName(static_cast<ProfilePhase>(p)),
+                      static_cast<unsigned long long>(histogram.count),
+                      static_cast<double>(histogram.totalNanoseconds) / 1e6, mean / 1e3,
+                      histogram.percentile(0.50) / 1e3, histogram.percentile(0.90) / 1e3,
+                      histogram.percentile(0.99) / 1e3);
+        out << line;
+    }
+}
+
+} // namespace profiler
+
+RollingProfile::RollingProfile(std::chrono::steady_clock::duration window)
+    : window(window),
+      windowStart(std::chrono::steady_clock::now()),
+      previous(profiler::collect()) {
+}
+
+bool RollingProfile::refresh() {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - windowStart < window) return false;
+    windowStart = now;
+
+    profiler::PhaseHistograms current = profiler::collect();
+    for (std::size_t p = 0; p < kProfilePhaseCount; ++p) {
+        profiler::Histogram recent = current[p];
+        recent -= previous[p];
+        stats[p] = { recent.count, recent.percentile(0.50), recent.percentile(0.99) };
+    }
+    previous = current;
+    return true;
+}
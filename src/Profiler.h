@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief Phases of a simulation tick and of a rendered frame
+ *
+ * Ant phases are timed per batch of up to 64 ants of one role, so their
+ * samples are batch durations; Tick is one whole World::update().
+ */
+enum class ProfilePhase : std::uint8_t {
+    Tick,
+    Sensing,
+    Decide,
+    ApplyActions,       // including the serial pheromone deposit pass
+    Move,               // including the occupancy rebuild
+    PheromoneDiffusion,
+    RenderTerrain,
+    RenderOverlay,
+    RenderFood,
+    RenderAnts,
+    Present,            // including any wait for the frame rate limit
+};
+
+constexpr std::size_t kProfilePhaseCount = 11;
+
+const char* profilePhaseName(ProfilePhase phase);
+
+/**
+ * @brief Process-wide, lock-free per-thread timing histograms
+ *
+ * Each thread records into its own histograms (registered once, on its first
+ * sample), so recording is two relaxed stores and never contends. collect()
+ * sums the histograms of every thread that ever recorded.
+ *
+ * Buckets are log-linear: exact below 16 ns, then 16 sub-buckets per power
+ * of two, so percentiles are within about 6%.
+ */
+namespace profiler {
+
+inline constexpr std::size_t kBucketCount = 608; // up to 2^40 ns
+
+struct Histogram {
+    std::array<std::uint64_t, kBucketCount> counts{};
+    std::uint64_t count = 0;
+    std::uint64_t totalNanoseconds = 0;
+
+    // Nanoseconds at quantile q in [0, 1]; 0 when empty.
+    double percentile(double q) const;
+    Histogram& operator-=(const Histogram& other);
+};
+
+using PhaseHistograms = std::array<Histogram, kProfilePhaseCount>;
+
+// Disabled by default; ScopedPhaseTimer does not read the clock while off.
+void setEnabled(bool enabled);
+bool isEnabled();
+
+void record(ProfilePhase phase, std::uint64_t nanoseconds);
+PhaseHistograms collect();
+
+// One line per phase with samples: count, total, mean and percentiles.
+void writeReport(std::ostream& out, const PhaseHistograms& histograms);
+
+} // namespace profiler
+
+/**
+ * @brief Times the enclosing scope into a profiler phase
+ */
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(ProfilePhase phase) : phase(phase), enabled(profiler::isEnabled()) {
+        if (enabled) start = Clock::now();
+    }
+    ~ScopedPhaseTimer() {
+        if (enabled) {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+            profiler::record(phase, static_cast<std::uint64_t>(elapsed.count()));
+        }
+    }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const ProfilePhase phase;
+    const bool enabled;
+    Clock::time_point start;
+};
+
+/**
+ * @brief p50/p99 per phase over a rolling window
+ *
+ * refresh() closes the current window once it is at least `window` long:
+ * the statistics then cover only samples recorded since the previous window
+ * closed.
+ */
+class RollingProfile {
+public:
+    struct PhaseStats {
+        std::uint64_t count = 0;
+        double p50 = 0.0; // nanoseconds
+        double p99 = 0.0;
+    };
+
+    explicit RollingProfile(std::chrono::steady_clock::duration window = std::chrono::seconds(1));
+
+    // Returns whether a new window was closed (and the stats changed).
+    bool refresh();
+    const PhaseStats& get(ProfilePhase phase) const { return stats[static_cast<std::size_t>(phase)]; }
+
+private:
+    const std::chrono::steady_clock::duration window;
+    std::chrono::steady_clock::time_point windowStart;
+    profiler::PhaseHistograms previous;
+    std::array<PhaseStats, kProfilePhaseCount> stats{};
+};
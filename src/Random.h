@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Counter-based random number generator
+ *
+ * Output n of a stream is a pure function of (key, n), so every ant can own
+ * an independent stream that does not depend on the order ants are updated
+ * in or on which thread updates them. Only 32-bit multiplies, shifts and
+ * xors are used, which keeps the hash cheap to evaluate for many streams at
+ * once. Satisfies UniformRandomBitGenerator so it works with <random>
+ * distributions.
+ */
+class CounterRng {
+private:
+    std::uint32_t keyLow;
+    std::uint32_t keyHigh;
+    std::uint32_t counter;
+
+public:
+    using result_type = std::uint32_t;
+
+    constexpr CounterRng(std::uint64_t key = 0, std::uint32_t counter = 0)
+        : keyLow(static_cast<std::uint32_t>(key)),
+          keyHigh(static_cast<std::uint32_t>(key >> 32)),
+          counter(counter) {}
+
+    // Stream for one entity (e.g. an ant id) derived from the world seed.
+    static constexpr CounterRng forStream(std::uint64_t seed, std::uint64_t streamId) {
+        return CounterRng(splitMix64(seed ^ splitMix64(streamId)));
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    constexpr result_type operator()() { return hash(keyLow, keyHigh, counter++); }
+
+    constexpr void discard(std::uint32_t draws) { counter += draws; }
+
+    constexpr std::uint32_t getCounter() const { return counter; }
+    constexpr std::uint64_t getKey() const {
+        return (static_cast<std::uint64_t>(keyHigh) << 32) | keyLow;
+    }
+
+    // Bijective 32-bit finalizer ("lowbias32").
+    static constexpr std::uint32_t mix32(std::uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // For a fixed key this is a permutation of the counter, so a stream only
+    // repeats after 2^32 draws.
+    static constexpr std::uint32_t hash(std::uint32_t keyLow, std::uint32_t keyHigh, std::uint32_t counter) {
+        return mix32(mix32(counter ^ keyLow) + keyHigh);
+    }
+
+    static constexpr std::uint64_t splitMix64(std::uint64_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+};
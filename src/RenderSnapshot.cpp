@@ -0,0 +1,45 @@
+#include <cstring>
+
+#include "PheromoneField.h"
+#include "RenderSnapshot.h"
+#include "World.h"
+
+void RenderSnapshot::capture(World& world) {
+    tick = world.getTick();
+    terrainRevision = world.getTerrainRevision();
+    tickDueAt = std::chrono::steady_clock::now();
+
+    const AntStore& ants = world.getAnts();
+    roles.assign(ants.roles.begin(), ants.roles.end());
+    positions.assign(ants.positions.begin(), ants.positions.end());
+    previousPositions.assign(ants.previousPositions.begin(), ants.previousPositions.end());
+
+    // The loaded chunk count is read first: a chunk loaded while scanning is
+    // then picked up again by the next capture.
+    const std::size_t chunkCount = world.getLoadedChunkCount();
+    if (food.empty() || foodRevision != world.getFoodRevision() || foodChunkCount != chunkCount) {
+        foodRevision = world.getFoodRevision();
+        foodChunkCount = chunkCount;
+        food.clear();
+        world.forEachLoadedTile([this](Tile* tile) {
+            if (tile->getHasFood()) {
+                const IntegerPosition pos = tile->getPosition();
+                food.push_back({ static_cast<std::uint32_t>(pos.getIntX()), static_cast<std::uint32_t>(pos.getIntY()),
+                                 tile->getFoodAmount() });
+            }
+        });
+    }
+
+    const PheromoneField& pheromones = world.getPheromones();
+    if (trailBlocks.empty() || trailRevision != pheromones.getRevision()) {
+        trailRevision = pheromones.getRevision();
+        const auto& active = pheromones.getActiveBlocks(PheromoneType::FoodTrail);
+        trailBlocks.assign(active.begin(), active.end());
+        trailValues.resize(trailBlocks.size() * PheromoneField::kBlockArea);
+        for (std::size_t i = 0; i < trailBlocks.size(); ++i) {
+            std::memcpy(trailValues.data() + i * PheromoneField::kBlockArea,
+                        pheromones.block(PheromoneType::FoodTrail, trailBlocks[i]),
+                        PheromoneField::kBlockArea * sizeof(float));
+        }
+    }
+}
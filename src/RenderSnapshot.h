@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "Ant.h"
+#include "Position.h"
+
+class World;
+
+/**
+ * @brief What the visualizer draws of one tick, copied out of the World
+ *
+ * Holds the ants' roles and current and previous positions (so a frame can
+ * interpolate between the two ticks like Ant::getPreviousPosition()), the
+ * tiles that hold food and a copy of the active FoodTrail blocks. Terrain is
+ * not copied: it only changes through World::setTerrain(), which is not
+ * called while ticking, so it can be drawn from the World directly.
+ *
+ * capture() reuses the snapshot's capacity, and skips food and trail data
+ * that have not changed since this snapshot last captured them.
+ */
+struct RenderSnapshot {
+    struct Food {
+        std::uint32_t x;
+        std::uint32_t y;
+        float amount;
+    };
+
+    std::uint64_t tick = 0;
+    std::uint64_t terrainRevision = 0;
+    // When this tick was due on the simulation clock and the time between
+    // ticks; zero steps mean "draw the current positions".
+    std::chrono::steady_clock::time_point tickDueAt;
+    float stepSeconds = 0.0f;
+    // Simulated seconds skipped so far because ticks did not fit in a frame.
+    float droppedSeconds = 0.0f;
+
+    std::vector<AntRole> roles;
+    std::vector<FloatPosition> positions;
+    std::vector<FloatPosition> previousPositions;
+
+    std::uint64_t foodRevision = 0;
+    std::size_t foodChunkCount = 0;
+    std::vector<Food> food;
+
+    std::uint64_t trailRevision = 0;
+    std::vector<std::uint32_t> trailBlocks;
+    std::vector<float> trailValues; // PheromoneField::kBlockArea per trail block
+
+    // Also sets tickDueAt to now; the simulation loop adjusts it afterwards.
+    void capture(World& world);
+
+    // How far a frame drawn at `now` is from the previous tick towards this one.
+    float interpolationAt(std::chrono::steady_clock::time_point now) const {
+        if (stepSeconds <= 0.0f) return 1.0f;
+        const std::chrono::duration<float> sinceTick = now - tickDueAt;
+        return std::clamp(sinceTick.count() / stepSeconds, 0.0f, 1.0f);
+    }
+};
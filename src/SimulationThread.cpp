@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <chrono>
+
+#include "SimulationThread.h"
+#include "World.h"
+
+SimulationThread::SimulationThread(World& world, float stepsPerSecond, float targetFrameRate)
+    : world(world),
+      stepsPerSecond(stepsPerSecond),
+      targetFrameRate(targetFrameRate) {
+    // Publish the initial state so the render thread always has a snapshot.
+    RenderSnapshot& initial = snapshots.writeBuffer();
+    initial.capture(world);
+    initial.previousPositions = initial.positions;
+    snapshots.publish();
+    thread = std::thread([this] { run(); });
+}
+
+SimulationThread::~SimulationThread() {
+    stopping.store(true, std::memory_order_relaxed);
+    thread.join();
+}
+
+const RenderSnapshot& SimulationThread::acquireSnapshot() {
+    snapshots.acquire();
+    return snapshots.readBuffer();
+}
+
+void SimulationThread::setRunMode(RunMode mode, float newMultiplier) {
+    multiplier.store(newMultiplier, std::memory_order_relaxed);
+    runMode.store(mode, std::memory_order_relaxed);
+}
+
+void SimulationThread::run() {
+    using namespace std::chrono;
+    // Sleep in short slices so the destructor is never kept waiting long.
+    static constexpr duration<float> kMaxSleep = milliseconds(10);
+
+    Timer timer(stepsPerSecond, targetFrameRate);
+    while (!stopping.load(std::memory_order_relaxed)) {
+        const RunMode mode = runMode.load(std::memory_order_relaxed);
+        const float speed = multiplier.load(std::memory_order_relaxed);
+        if (mode != timer.getRunMode() || speed != timer.getMultiplier()) {
+            timer.setRunMode(mode, speed);
+        }
+
+        const int steps = timer.getSimulationStepsToRun();
+        if (steps == 0) {
+            std::this_thread::sleep_for(std::min(duration<float>(timer.getTimeUntilNextStep()), kMaxSleep));
+            continue;
+        }
+        const auto batchStart = steady_clock::now();
+        for (int i = 0; i < steps; ++i) {
+            world.update();
+        }
+        timer.recordSimulationTime(steps, duration<float>(steady_clock::now() - batchStart).count());
+
+        RenderSnapshot& snapshot = snapshots.writeBuffer();
+        snapshot.capture(world);
+        snapshot.stepSeconds = timer.getWallClockStepSize();
+        snapshot.tickDueAt -= duration_cast<steady_clock::duration>(
+            duration<float>(timer.getInterpolation() * snapshot.stepSeconds));
+        snapshot.droppedSeconds = timer.getDroppedTime();
+        snapshots.publish();
+    }
+}
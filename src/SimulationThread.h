@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "RenderSnapshot.h"
+#include "Timer.h"
+#include "TripleBuffer.h"
+
+class World;
+
+/**
+ * @brief Runs World::update() on its own thread
+ *
+ * Ticks are paced by a Timer in the selected RunMode and batched so that a
+ * snapshot goes out at least at the target frame rate.
+ *
+ * After every batch of ticks the thread captures a RenderSnapshot into a
+ * triple buffer, so the render thread never touches live ant or pheromone
+ * state and neither side waits for the other: a slow frame does not hold
+ * back the simulation and a slow tick does not stall the window.
+ *
+ * The world must not be modified by anyone else while the thread runs,
+ * except for loading tile chunks, which is thread-safe.
+ */
+class SimulationThread {
+public:
+    SimulationThread(World& world, float stepsPerSecond, float targetFrameRate = 60.0f);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    // The latest published snapshot (render thread only). Stays valid until
+    // the next call.
+    const RenderSnapshot& acquireSnapshot();
+
+    // Takes effect before the next batch of ticks. Callable from any thread.
+    void setRunMode(RunMode mode, float multiplier = 1.0f);
+    RunMode getRunMode() const { return runMode.load(std::memory_order_relaxed); }
+    float getMultiplier() const { return multiplier.load(std::memory_order_relaxed); }
+
+private:
+    World& world;
+    const float stepsPerSecond;
+    const float targetFrameRate;
+    TripleBuffer<RenderSnapshot> snapshots;
+    std::atomic<RunMode> runMode{RunMode::RealTime};
+    std::atomic<float> multiplier{1.0f};
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+
+    void run();
+};
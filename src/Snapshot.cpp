@@ -0,0 +1,533 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Random.h"
+#include "Snapshot.h"
+#include "World.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ANTS_SNAPSHOT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace snapshot;
+
+namespace {
+
+constexpr std::size_t kDataStart = sizeof(FileHeader) + kMaxSections * sizeof(SectionEntry);
+constexpr std::size_t kChunkArea = TileStore::kChunkArea;
+constexpr std::size_t kBlockArea = PheromoneField::kBlockArea;
+
+static_assert(kDataStart % kSectionAlignment == 0);
+static_assert(kItemTypeCount == 3, "AntRecord::carried has one slot per item type");
+
+SectionId pheromoneBlocksSection(std::size_t channel) {
+    return static_cast<SectionId>(static_cast<std::uint32_t>(SectionId::PheromoneBlocks) + 2 * channel);
+}
+
+SectionId pheromoneDataSection(std::size_t channel) {
+    return static_cast<SectionId>(static_cast<std::uint32_t>(SectionId::PheromoneData) + 2 * channel);
+}
+
+/**
+ * @brief Streams sections into a temporary file and renames it into place
+ *
+ * The header and section table are written last, so a crash mid-write never
+ * leaves a truncated file under the final name.
+ */
+class SnapshotWriter {
+private:
+    std::filesystem::path path;
+    std::filesystem::path temporaryPath;
+    std::ofstream out;
+    FileHeader header{};
+    std::array<SectionEntry, kMaxSections> entries{};
+    std::uint64_t position = kDataStart;
+    std::uint64_t sectionStart = 0;
+
+    void pad() {
+        static constexpr char zeros[kSectionAlignment] = {};
+        const std::size_t padding = (kSectionAlignment - position % kSectionAlignment) % kSectionAlignment;
+        out.write(zeros, static_cast<std::streamsize>(padding));
+        position += padding;
+    }
+
+public:
+    SnapshotWriter(const std::filesystem::path& path, Kind kind, std::uint64_t snapshotId,
+                   std::uint64_t baseSnapshotId, std::uint64_t tick)
+        : path(path), temporaryPath(path.string() + ".tmp"),
+          out(temporaryPath, std::ios::binary | std::ios::trunc) {
+        if (!out) throw std::runtime_error("Cannot open " + temporaryPath.string() + " for writing");
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kFormatVersion;
+        header.kind = kind;
+        header.snapshotId = snapshotId;
+        header.baseSnapshotId = baseSnapshotId;
+        header.tick = tick;
+        header.byteOrderMark = kByteOrderMark;
+        const std::vector<char> placeholder(kDataStart, 0);
+        out.write(placeholder.data(), static_cast<std::streamsize>(placeholder.size()));
+    }
+
+    void beginSection(SectionId id, std::uint32_t elementSize) {
+        if (header.sectionCount == kMaxSections) throw std::logic_error("Too many snapshot sections");
+        entries[header.sectionCount] = { .id = id, .elementSize = elementSize, .offset = position, .count = 0 };
+        sectionStart = position;
+    }
+
+    void write(const void* data, std::size_t bytes) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        position += bytes;
+    }
+
+    void endSection() {
+        SectionEntry& entry = entries[header.sectionCount++];
+        entry.count = (position - sectionStart) / entry.elementSize;
+        pad();
+    }
+
+    template <typename T>
+    void section(SectionId id, std::span<const T> values) {
+        beginSection(id, sizeof(T));
+        write(values.data(), values.size_bytes());
+        endSection();
+    }
+
+    void finish() {
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), sizeof(entries));
+        out.close();
+        if (!out) throw std::runtime_error("Failed to write " + temporaryPath.string());
+        std::filesystem::rename(temporaryPath, path);
+    }
+};
+
+std::uint64_t newSnapshotId(const World& world) {
+    const auto now = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    return CounterRng::splitMix64(now ^ CounterRng::splitMix64(world.getTick() ^ (std::uint64_t{world.getSeed()} << 32)));
+}
+
+std::string mersenneState(const std::mt19937& rng) {
+    std::ostringstream state;
+    state << rng;
+    return state.str();
+}
+
+} // namespace
+
+namespace snapshot {
+
+SnapshotView::SnapshotView(const std::filesystem::path& path) {
+#ifdef ANTS_SNAPSHOT_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open snapshot " + path.string());
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        size = static_cast<std::size_t>(info.st_size);
+        void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            data = static_cast<const std::byte*>(address);
+            mapped = true;
+        }
+    }
+    ::close(fd);
+#endif
+    if (!mapped) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) throw std::runtime_error("Cannot open snapshot " + path.string());
+        size = static_cast<std::size_t>(in.tellg());
+        buffer = std::make_unique<std::byte[]>(size);
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(buffer.get()), static_cast<std::streamsize>(size));
+        data = buffer.get();
+    }
+
+    if (size < kDataStart) throw std::runtime_error(path.string() + " is too small to be a snapshot");
+    const FileHeader& header = getHeader();
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error(path.string() + " is not a snapshot");
+    }
+    if (header.version != kFormatVersion) {
+        throw std::runtime_error(path.string() + " has unsupported snapshot version " + std::to_string(header.version));
+    }
+    if (header.byteOrderMark != kByteOrderMark) {
+        throw std::runtime_error(path.string() + " was written with a different byte order");
+    }
+    if (header.sectionCount > kMaxSections) throw std::runtime_error(path.string() + " has a corrupt section table");
+    const auto* entries = reinterpret_cast<const SectionEntry*>(data + sizeof(FileHeader));
+    for (std::uint32_t i = 0; i < header.sectionCount; ++i) {
+        const SectionEntry& entry = entries[i];
+        const bool fits = entry.elementSize > 0 && entry.offset % kSectionAlignment == 0 && entry.offset <= size &&
+                          entry.count <= (size - entry.offset) / entry.elementSize;
+        if (!fits) throw std::runtime_error(path.string() + " has a corrupt section table");
+    }
+    if (!hasSection(SectionId::Meta)) throw std::runtime_error(path.string() + " has no world metadata");
+}
+
+SnapshotView::~SnapshotView() {
+#ifdef ANTS_SNAPSHOT_MMAP
+    if (mapped) {
+        ::munmap(const_cast<std::byte*>(data), size);
+    }
+#endif
+}
+
+const SectionEntry* SnapshotView::findSection(SectionId id) const {
+    const auto* entries = reinterpret_cast<const SectionEntry*>(data + sizeof(FileHeader));
+    for (std::uint32_t i = 0; i < getHeader().sectionCount; ++i) {
+        if (entries[i].id == id) return &entries[i];
+    }
+    return nullptr;
+}
+
+void SnapshotView::checkElementSize(const SectionEntry& entry, std::size_t expected) {
+    if (entry.elementSize != expected) {
+        throw std::runtime_error("Snapshot section " + std::to_string(static_cast<std::uint32_t>(entry.id)) +
+                                 " has records of " + std::to_string(entry.elementSize) + " bytes, expected " +
+                                 std::to_string(expected));
+    }
+}
+
+} // namespace snapshot
+
+namespace {
+
+void savePheromones(const PheromoneField& pheromones, SnapshotWriter& writer) {
+    for (std::size_t channel = 0; channel < kPheromoneTypeCount; ++channel) {
+        const auto type = static_cast<PheromoneType>(channel);
+        std::vector<std::uint32_t> blocks = pheromones.getActiveBlocks(type);
+        std::sort(blocks.begin(), blocks.end());
+        writer.section(pheromoneBlocksSection(channel), std::span<const std::uint32_t>(blocks));
+        writer.beginSection(pheromoneDataSection(channel), sizeof(float));
+        for (const std::uint32_t block : blocks) {
+            writer.write(pheromones.block(type, block), kBlockArea * sizeof(float));
+        }
+        writer.endSection();
+    }
+}
+
+void restorePheromones(PheromoneField& pheromones, const SnapshotView& view) {
+    for (std::size_t channel = 0; channel < kPheromoneTypeCount; ++channel) {
+        const auto blocks = view.section<std::uint32_t>(pheromoneBlocksSection(channel));
+        const auto values = view.section<float>(pheromoneDataSection(channel));
+        if (values.size() != blocks.size() * kBlockArea) throw std::runtime_error("Snapshot pheromone data is truncated");
+        const std::size_t blockCount = static_cast<std::size_t>(pheromones.getBlocksX()) * pheromones.getBlocksY();
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            if (blocks[i] >= blockCount) throw std::runtime_error("Snapshot pheromone block is out of range");
+            pheromones.setBlock(static_cast<PheromoneType>(channel), blocks[i], values.data() + i * kBlockArea);
+        }
+    }
+}
+
+AntRecord makeAntRecord(const AntStore& ants, std::size_t i) {
+    AntRecord record{};
+    record.id = ants.ids[i];
+    record.role = static_cast<std::uint8_t>(ants.roles[i]);
+    record.headingToDestination = ants.headingToDestination[i];
+    record.x = ants.positions[i].getX();
+    record.y = ants.positions[i].getY();
+    record.previousX = ants.previousPositions[i].getX();
+    record.previousY = ants.previousPositions[i].getY();
+    record.directionX = ants.lastDirections[i].x;
+    record.directionY = ants.lastDirections[i].y;
+    record.movementSpeed = ants.movementSpeeds[i];
+    record.maxLoad = ants.maxLoads[i];
+    record.wanderRandomness = ants.wanderRandomness[i];
+    std::copy(ants.carriedItems[i].begin(), ants.carriedItems[i].end(), record.carried);
+    record.destinationX = ants.destinations[i].getX();
+    record.destinationY = ants.destinations[i].getY();
+    record.rngKey = ants.rngs[i].getKey();
+    record.rngCounter = ants.rngs[i].getCounter();
+    return record;
+}
+
+void restoreAnt(AntStore& ants, const AntRecord& record) {
+    const std::size_t i = ants.add(record.id, static_cast<AntRole>(record.role), FloatPosition(record.x, record.y),
+                                   CounterRng(record.rngKey, record.rngCounter));
+    ants.headingToDestination[i] = record.headingToDestination;
+    ants.previousPositions[i] = FloatPosition(record.previousX, record.previousY);
+    ants.lastDirections[i] = Vector2D(record.directionX, record.directionY);
+    ants.movementSpeeds[i] = record.movementSpeed;
+    ants.maxLoads[i] = record.maxLoad;
+    ants.wanderRandomness[i] = record.wanderRandomness;
+    std::copy(std::begin(record.carried), std::end(record.carried), ants.carriedItems[i].begin());
+    ants.destinations[i] = FloatPosition(record.destinationX, record.destinationY);
+}
+
+std::uint8_t tileFlags(const Tile& tile) {
+    return tile.getIsNestEntrance() ? kTileNestEntrance : 0;
+}
+
+void restoreTile(Tile& tile, std::uint8_t terrain, std::uint8_t flags, float food) {
+    tile.setTerrain(static_cast<TerrainType>(terrain));
+    tile.setNestEntrance((flags & kTileNestEntrance) != 0);
+    tile.removeFood(tile.getFoodAmount());
+    if (food > 0.0f) {
+        tile.addFood(food);
+    }
+}
+
+} // namespace
+
+std::uint64_t WorldSnapshot::save(const World& world, const std::filesystem::path& path) {
+    const TileStore& tiles = world.tiles;
+    const AntStore& ants = world.ants;
+    const std::uint64_t id = newSnapshotId(world);
+    SnapshotWriter writer(path, Kind::Full, id, 0, world.getTick());
+
+    const WorldMeta meta = makeMeta(world);
+    writer.section(SectionId::Meta, std::span<const WorldMeta>(&meta, 1));
+    const std::string rngState = mersenneState(world.rng);
+    writer.section(SectionId::MersenneState, std::span<const char>(rngState));
+
+    std::vector<std::uint32_t> loadedChunks;
+    for (std::size_t chunk = 0; chunk < tiles.getChunkCount(); ++chunk) {
+        if (tiles.findChunk(chunk)) loadedChunks.push_back(static_cast<std::uint32_t>(chunk));
+    }
+    writer.section(SectionId::ChunkIndex, std::span<const std::uint32_t>(loadedChunks));
+
+    std::array<std::uint8_t, kChunkArea> bytePlane;
+    std::array<float, kChunkArea> floatPlane;
+    writer.beginSection(SectionId::ChunkTerrain, sizeof(std::uint8_t));
+    for (const std::uint32_t chunk : loadedChunks) {
+        const Tile* chunkTiles = tiles.findChunk(chunk);
+        for (std::size_t i = 0; i < kChunkArea; ++i) {
+            bytePlane[i] = static_cast<std::uint8_t>(chunkTiles[i].getTerrain());
+        }
+        writer.write(bytePlane.data(), sizeof(bytePlane));
+    }
+    writer.endSection();
+    writer.beginSection(SectionId::ChunkFlags, sizeof(std::uint8_t));
+    for (const std::uint32_t chunk : loadedChunks) {
+        const Tile* chunkTiles = tiles.findChunk(chunk);
+        for (std::size_t i = 0; i < kChunkArea; ++i) {
+            bytePlane[i] = tileFlags(chunkTiles[i]);
+        }
+        writer.write(bytePlane.data(), sizeof(bytePlane));
+    }
+    writer.endSection();
+    writer.beginSection(SectionId::ChunkFood, sizeof(float));
+    for (const std::uint32_t chunk : loadedChunks) {
+        const Tile* chunkTiles = tiles.findChunk(chunk);
+        for (std::size_t i = 0; i < kChunkArea; ++i) {
+            floatPlane[i] = chunkTiles[i].getFoodAmount();
+        }
+        writer.write(floatPlane.data(), sizeof(floatPlane));
+    }
+    writer.endSection();
+
+    writer.beginSection(SectionId::Ants, sizeof(AntRecord));
+    for (std::size_t i = 0; i < ants.size(); ++i) {
+        const AntRecord record = makeAntRecord(ants, i);
+        writer.write(&record, sizeof(record));
+    }
+    writer.endSection();
+
+    savePheromones(world.pheromones, writer);
+    writer.finish();
+    return id;
+}
+
+WorldMeta WorldSnapshot::makeMeta(const World& world) {
+    WorldMeta meta{};
+    meta.width = world.width;
+    meta.height = world.height;
+    meta.seed = world.getSeed();
+    meta.nextAntId = world.idGenerator.peekNextId();
+    meta.tick = world.getTick();
+    meta.antCount = world.ants.size();
+    meta.antsGroupedByRole = world.ants.isGroupedByRole();
+    if (world.nestEntrancePosition) {
+        meta.hasNest = 1;
+        meta.nestX = world.nestEntrancePosition->getIntX();
+        meta.nestY = world.nestEntrancePosition->getIntY();
+    }
+    return meta;
+}
+
+void WorldSnapshot::saveDelta(const World& world, const SnapshotView& base, const std::filesystem::path& path) {
+    const WorldMeta& baseMeta = base.getMeta();
+    if (base.getHeader().kind != Kind::Full) throw std::invalid_argument("Delta checkpoints need a full base snapshot");
+    if (baseMeta.width != world.width || baseMeta.height != world.height || baseMeta.seed != world.getSeed()) {
+        throw std::invalid_argument("Base snapshot belongs to a different world");
+    }
+
+    SnapshotWriter writer(path, Kind::Delta, newSnapshotId(world), base.getHeader().snapshotId, world.getTick());
+    const WorldMeta meta = makeMeta(world);
+    writer.section(SectionId::Meta, std::span<const WorldMeta>(&meta, 1));
+    const std::string rngState = mersenneState(world.rng);
+    writer.section(SectionId::MersenneState, std::span<const char>(rngState));
+
+    // Tiles: compare each loaded chunk with the base, or with freshly
+    // generated tiles when the chunk was not loaded at the time of the base.
+    const TileStore& tiles = world.tiles;
+    const auto baseChunks = base.section<std::uint32_t>(SectionId::ChunkIndex);
+    const auto baseTerrain = base.section<std::uint8_t>(SectionId::ChunkTerrain);
+    const auto baseFlags = base.section<std::uint8_t>(SectionId::ChunkFlags);
+    const auto baseFood = base.section<float>(SectionId::ChunkFood);
+    const unsigned int chunksX = tiles.getChunksX();
+    writer.beginSection(SectionId::TileChanges, sizeof(TileChange));
+    for (std::size_t chunk = 0; chunk < tiles.getChunkCount(); ++chunk) {
+        const Tile* chunkTiles = tiles.findChunk(chunk);
+        if (!chunkTiles) continue;
+        const auto found = std::lower_bound(baseChunks.begin(), baseChunks.end(), chunk);
+        const bool inBase = found != baseChunks.end() && *found == chunk;
+        const std::size_t baseOffset = static_cast<std::size_t>(found - baseChunks.begin()) * kChunkArea;
+        const unsigned int originX = static_cast<unsigned int>(chunk % chunksX) << TileStore::kChunkShift;
+        const unsigned int originY = static_cast<unsigned int>(chunk / chunksX) << TileStore::kChunkShift;
+
+        for (std::size_t i = 0; i < kChunkArea; ++i) {
+            const Tile& tile = chunkTiles[i];
+            const unsigned int x = originX + static_cast<unsigned int>(i % TileStore::kChunkSize);
+            const unsigned int y = originY + static_cast<unsigned int>(i / TileStore::kChunkSize);
+            if (x >= world.width || y >= world.height) continue;
+
+            const auto terrain = static_cast<std::uint8_t>(tile.getTerrain());
+            const std::uint8_t flags = tileFlags(tile);
+            const float food = tile.getFoodAmount();
+            bool changed;
+            if (inBase) {
+                changed = terrain != baseTerrain[baseOffset + i] || flags != baseFlags[baseOffset + i] ||
+                          food != baseFood[baseOffset + i];
+            } else {
+                Tile generated(IntegerPosition(x, y));
+                world.generateTile(generated);
+                changed = terrain != static_cast<std::uint8_t>(generated.getTerrain()) ||
+                          flags != tileFlags(generated) || food != generated.getFoodAmount();
+            }
+            if (changed) {
+                const TileChange change{
+                    .tileIndex = static_cast<std::uint64_t>(y) * world.width + x,
+                    .terrain = terrain,
+                    .flags = flags,
+                    .reserved = 0,
+                    .food = food,
+                };
+                writer.write(&change, sizeof(change));
+            }
+        }
+    }
+    writer.endSection();
+
+    // Ants: a moving ant changes every tick, so usually most records differ
+    // from the base. Changes carry an index on top of the record, so they
+    // are only written when they come out smaller than all the records.
+    const AntStore& ants = world.ants;
+    const auto baseAnts = base.section<AntRecord>(SectionId::Ants);
+    auto antChanged = [&](std::size_t i, const AntRecord& record) {
+        return i >= baseAnts.size() || std::memcmp(&record, &baseAnts[i], sizeof(AntRecord)) != 0;
+    };
+    std::size_t changedAnts = 0;
+    for (std::size_t i = 0; i < ants.size(); ++i) {
+        changedAnts += antChanged(i, makeAntRecord(ants, i));
+    }
+    if (changedAnts * sizeof(AntChange) < ants.size() * sizeof(AntRecord)) {
+        writer.beginSection(SectionId::AntChanges, sizeof(AntChange));
+        for (std::size_t i = 0; i < ants.size(); ++i) {
+            const AntChange change{ .antIndex = i, .ant = makeAntRecord(ants, i) };
+            if (antChanged(i, change.ant)) {
+                writer.write(&change, sizeof(change));
+            }
+        }
+    } else {
+        writer.beginSection(SectionId::Ants, sizeof(AntRecord));
+        for (std::size_t i = 0; i < ants.size(); ++i) {
+            const AntRecord record = makeAntRecord(ants, i);
+            writer.write(&record, sizeof(record));
+        }
+    }
+    writer.endSection();
+
+    savePheromones(world.pheromones, writer);
+    writer.finish();
+}
+
+std::unique_ptr<World> WorldSnapshot::load(const std::filesystem::path& path,
+                                           const std::optional<std::filesystem::path>& deltaPath,
+                                           const std::optional<std::filesystem::path>& chunkBackingFile) {
+    const SnapshotView base(path);
+    if (base.getHeader().kind != Kind::Full) throw std::runtime_error(path.string() + " is not a full snapshot");
+    std::unique_ptr<SnapshotView> delta;
+    if (deltaPath) {
+        delta = std::make_unique<SnapshotView>(*deltaPath);
+        if (delta->getHeader().kind != Kind::Delta ||
+            delta->getHeader().baseSnapshotId != base.getHeader().snapshotId) {
+            throw std::runtime_error(deltaPath->string() + " is not a delta of " + path.string());
+        }
+    }
+    const SnapshotView& latest = delta ? *delta : base;
+    const WorldMeta& meta = latest.getMeta();
+
+    std::unique_ptr<World> world(new World(meta.width, meta.height, meta.seed, meta.antCount, chunkBackingFile,
+                                           World::Uninitialized{}));
+    world->tick = meta.tick;
+    world->idGenerator.setNextId(meta.nextAntId);
+    if (meta.hasNest) {
+        world->nestEntrancePosition = std::make_unique<IntegerPosition>(meta.nestX, meta.nestY);
+    }
+    const auto rngState = latest.section<char>(SectionId::MersenneState);
+    std::istringstream(std::string(rngState.begin(), rngState.end())) >> world->rng;
+
+    // Tiles: base chunks first, then individual changes from the delta.
+    const auto chunks = base.section<std::uint32_t>(SectionId::ChunkIndex);
+    const auto terrain = base.section<std::uint8_t>(SectionId::ChunkTerrain);
+    const auto flags = base.section<std::uint8_t>(SectionId::ChunkFlags);
+    const auto food = base.section<float>(SectionId::ChunkFood);
+    if (terrain.size() != chunks.size() * kChunkArea || flags.size() != terrain.size() || food.size() != terrain.size()) {
+        throw std::runtime_error(path.string() + " has truncated tile planes");
+    }
+    for (std::size_t slot = 0; slot < chunks.size(); ++slot) {
+        if (chunks[slot] >= world->tiles.getChunkCount()) throw std::runtime_error(path.string() + " has a corrupt chunk index");
+        Tile* chunkTiles = world->tiles.chunkTiles(chunks[slot]);
+        for (std::size_t i = 0; i < kChunkArea; ++i) {
+            const std::size_t offset = slot * kChunkArea + i;
+            restoreTile(chunkTiles[i], terrain[offset], flags[offset], food[offset]);
+        }
+    }
+    if (delta) {
+        for (const TileChange& change : delta->section<TileChange>(SectionId::TileChanges)) {
+            Tile* tile = world->getTile(static_cast<int>(change.tileIndex % meta.width),
+                                        static_cast<int>(change.tileIndex / meta.width));
+            if (!tile) throw std::runtime_error(deltaPath->string() + " changes a tile outside the world");
+            restoreTile(*tile, change.terrain, change.flags, change.food);
+        }
+    }
+
+    // Ants: the base records, overridden (and extended) by the delta, or
+    // the delta's own records when it has all of them.
+    const bool deltaHasAnts = delta && delta->hasSection(SectionId::Ants);
+    const auto baseAnts = (deltaHasAnts ? *delta : base).section<AntRecord>(SectionId::Ants);
+    std::vector<const AntRecord*> records(meta.antCount, nullptr);
+    for (std::size_t i = 0; i < std::min<std::size_t>(baseAnts.size(), records.size()); ++i) {
+        records[i] = &baseAnts[i];
+    }
+    if (delta && !deltaHasAnts) {
+        for (const AntChange& change : delta->section<AntChange>(SectionId::AntChanges)) {
+            if (change.antIndex >= records.size()) throw std::runtime_error(deltaPath->string() + " has a corrupt ant change");
+            records[change.antIndex] = &change.ant;
+        }
+    }
+    world->ants.reserve(records.size());
+    for (const AntRecord* record : records) {
+        if (!record) throw std::runtime_error("Snapshot is missing ant records");
+        restoreAnt(world->ants, *record);
+    }
+    if (meta.antsGroupedByRole) {
+        world->ants.groupByRole();
+    }
+
+    restorePheromones(world->pheromones, latest);
+    world->occupancy.rebuild(world->ants.positions);
+    return world;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+class World;
+
+/**
+ * @brief Versioned binary world snapshots
+ *
+ * A snapshot file is a fixed header, a section table and a run of sections,
+ * each starting on a 64-byte boundary. Sections are flat arrays of
+ * trivially copyable records in host byte order, so a mapped file can be used
+ * in place: the tile planes of a snapshot are plain uint8/float arrays, one
+ * kChunkArea run per loaded chunk, and pheromone blocks are stored exactly as
+ * PheromoneField keeps them.
+ *
+ * Only loaded tile chunks are written; the rest of the world is regenerated
+ * from the seed on load, which gives the same tiles because untouched chunks
+ * are a pure function of the seed.
+ *
+ * A delta checkpoint refers to one full snapshot by id and holds only the
+ * tiles that differ from it, plus the (small) pheromone trail and global
+ * state. Ants go in as AntChanges for the ants that differ when that is
+ * smaller than writing every ant, and as a plain Ants section otherwise:
+ * ants that move change every tick, so a delta taken a few ticks after its
+ * base usually carries all of them. Deltas are not chained: each applies directly to its full
+ * snapshot, so restoring a run needs at most two files.
+ */
+namespace snapshot {
+
+inline constexpr char kMagic[8] = {'A', 'N', 'T', 'S', 'N', 'A', 'P', '\0'};
+inline constexpr std::uint32_t kFormatVersion = 1;
+inline constexpr std::uint32_t kByteOrderMark = 0x01020304u;
+inline constexpr std::size_t kSectionAlignment = 64;
+inline constexpr std::size_t kMaxSections = 40;
+
+enum class Kind : std::uint32_t {
+    Full = 0,
+    Delta = 1,
+};
+
+enum class SectionId : std::uint32_t {
+    Meta = 1,             // one WorldMeta
+    MersenneState = 2,    // chars: the world's std::mt19937 in text form
+    ChunkIndex = 3,       // uint32 per loaded chunk, ascending (full only)
+    ChunkTerrain = 4,     // uint8 TerrainType, kChunkArea per loaded chunk
+    ChunkFlags = 5,       // uint8 TileFlags, kChunkArea per loaded chunk
+    ChunkFood = 6,        // float, kChunkArea per loaded chunk
+    Ants = 7,             // AntRecord per ant (full; delta without AntChanges)
+    TileChanges = 8,      // TileChange (delta only)
+    AntChanges = 9,       // AntChange (delta only)
+    PheromoneBlocks = 16, // + 2 * channel: uint32 block index per active block
+    PheromoneData = 17,   // + 2 * channel: kBlockArea floats per active block
+};
+
+enum TileFlags : std::uint8_t {
+    kTileNestEntrance = 1u << 0,
+};
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    Kind kind;
+    std::uint64_t snapshotId;
+    std::uint64_t baseSnapshotId; // delta: id of the full snapshot it applies to
+    std::uint64_t tick;
+    std::uint32_t sectionCount;
+    std::uint32_t byteOrderMark;
+    std::uint32_t reserved[4];
+};
+
+struct SectionEntry {
+    SectionId id;
+    std::uint32_t elementSize;
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+struct WorldMeta {
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t seed;
+    std::int32_t nextAntId;
+    std::uint64_t tick;
+    std::uint64_t antCount;
+    std::uint32_t nestX;
+    std::uint32_t nestY;
+    std::uint8_t hasNest;
+    std::uint8_t antsGroupedByRole;
+    std::uint8_t reserved[6];
+};
+
+struct AntRecord {
+    std::int32_t id;
+    std::uint8_t role;
+    std::uint8_t headingToDestination;
+    std::uint16_t reserved;
+    float x;
+    float y;
+    float previousX;
+    float previousY;
+    float directionX;
+    float directionY;
+    float movementSpeed;
+    float maxLoad;
+    float wanderRandomness;
+    float carried[3];
+    float destinationX;
+    float destinationY;
+    std::uint64_t rngKey;
+    std::uint32_t rngCounter;
+    std::uint32_t reserved2;
+};
+
+struct TileChange {
+    std::uint64_t tileIndex; // y * width + x
+    std::uint8_t terrain;
+    std::uint8_t flags;
+    std::uint16_t reserved;
+    float food;
+};
+
+struct AntChange {
+    std::uint64_t antIndex;
+    AntRecord ant;
+};
+
+static_assert(sizeof(FileHeader) == 64);
+static_assert(sizeof(WorldMeta) == 48);
+static_assert(sizeof(AntRecord) == 80);
+static_assert(sizeof(TileChange) == 16);
+static_assert(std::is_trivially_copyable_v<AntChange>);
+
+/**
+ * @brief Read-only view of a snapshot file, memory-mapped where supported
+ *
+ * Validates the header and section table on open and throws
+ * std::runtime_error if the file is not a snapshot of this format version.
+ */
+class SnapshotView {
+public:
+    explicit SnapshotView(const std::filesystem::path& path);
+    ~SnapshotView();
+
+    SnapshotView(const SnapshotView&) = delete;
+    SnapshotView& operator=(const SnapshotView&) = delete;
+
+    const FileHeader& getHeader() const { return *reinterpret_cast<const FileHeader*>(data); }
+    const WorldMeta& getMeta() const { return section<WorldMeta>(SectionId::Meta)[0]; }
+    bool hasSection(SectionId id) const { return findSection(id) != nullptr; }
+
+    // Empty if the section is missing. Throws if its record size is not T's.
+    template <typename T>
+    std::span<const T> section(SectionId id) const {
+        const SectionEntry* entry = findSection(id);
+        if (!entry) return {};
+        checkElementSize(*entry, sizeof(T));
+        return { reinterpret_cast<const T*>(data + entry->offset), static_cast<std::size_t>(entry->count) };
+    }
+
+private:
+    const std::byte* data = nullptr;
+    std::size_t size = 0;
+    bool mapped = false;
+    std::unique_ptr<std::byte[]> buffer;
+
+    const SectionEntry* findSection(SectionId id) const;
+    static void checkElementSize(const SectionEntry& entry, std::size_t expected);
+};
+
+} // namespace snapshot
+
+/**
+ * @brief Writes World state to snapshot files and restores it
+ */
+class WorldSnapshot {
+public:
+    // Returns the id of the written snapshot.
+    static std::uint64_t save(const World& world, const std::filesystem::path& path);
+    // Writes the changes since `base`, which must be a full snapshot of this run.
+    static void saveDelta(const World& world, const snapshot::SnapshotView& base,
+                          const std::filesystem::path& path);
+    // Restores a world from a full snapshot and optionally one of its deltas.
+    static std::unique_ptr<World> load(const std::filesystem::path& path,
+                                       const std::optional<std::filesystem::path>& deltaPath = std::nullopt,
+                                       const std::optional<std::filesystem::path>& chunkBackingFile = std::nullopt);
+
+private:
+    static snapshot::WorldMeta makeMeta(const World& world);
+};
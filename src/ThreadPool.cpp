@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace {
+
+constexpr std::uint64_t pack(std::uint32_t begin, std::uint32_t end) {
+    return (static_cast<std::uint64_t>(begin) << 32) | end;
+}
+
+constexpr std::uint32_t rangeBegin(std::uint64_t packed) { return static_cast<std::uint32_t>(packed >> 32); }
+constexpr std::uint32_t rangeEnd(std::uint64_t packed) { return static_cast<std::uint32_t>(packed); }
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : ranges(std::make_unique<ChunkRange[]>(std::max(threadCount, 1u))),
+      participantCount(std::max(threadCount, 1u)) {
+    workers.reserve(participantCount - 1);
+    for (unsigned int participant = 1; participant < participantCount; ++participant) {
+        workers.emplace_back([this, participant] { workerLoop(participant); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop(unsigned int participant) {
+    std::uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex);
+            workAvailable.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+        participate(participant);
+        {
+            std::lock_guard lock(mutex);
+            --busyWorkers;
+        }
+        workDone.notify_one();
+    }
+}
+
+bool ThreadPool::popChunk(unsigned int participant, std::uint32_t& chunk) {
+    auto& range = ranges[participant].packed;
+    std::uint64_t current = range.load(std::memory_order_acquire);
+    while (rangeBegin(current) < rangeEnd(current)) {
+        const std::uint64_t next = pack(rangeBegin(current) + 1, rangeEnd(current));
+        if (range.compare_exchange_weak(current, next, std::memory_order_acq_rel)) {
+            chunk = rangeBegin(current);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::stealChunks(unsigned int thief) {
+    for (unsigned int offset = 1; offset < participantCount; ++offset) {
+        const unsigned int victim = (thief + offset) % participantCount;
+        auto& range = ranges[victim].packed;
+        std::uint64_t current = range.load(std::memory_order_acquire);
+        while (rangeBegin(current) < rangeEnd(current)) {
+            const std::uint32_t begin = rangeBegin(current);
+            const std::uint32_t end = rangeEnd(current);
+            const std::uint32_t taken = (end - begin + 1) / 2;
+            if (range.compare_exchange_weak(current, pack(begin, end - taken), std::memory_order_acq_rel)) {
+                // Our own range is empty, so nobody else can be modifying it.
+                ranges[thief].packed.store(pack(end - taken, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::participate(unsigned int participant) {
+    do {
+        std::uint32_t chunk;
+        while (popChunk(participant, chunk)) {
+            const std::size_t begin = static_cast<std::size_t>(chunk) * grainSize;
+            const std::size_t end = std::min(begin + grainSize, itemCount);
+            body(bodyContext, begin, end, participant);
+        }
+    } while (stealChunks(participant));
+}
+
+void ThreadPool::run(std::size_t count, std::size_t grain, Body loopBody, void* context) {
+    if (count == 0) return;
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunkCount = (count + grain - 1) / grain;
+
+    if (participantCount == 1 || chunkCount == 1) {
+        loopBody(context, 0, count, 0);
+        return;
+    }
+
+    body = loopBody;
+    bodyContext = context;
+    itemCount = count;
+    grainSize = grain;
+    for (unsigned int participant = 0; participant < participantCount; ++participant) {
+        const auto begin = static_cast<std::uint32_t>(chunkCount * participant / participantCount);
+        const auto end = static_cast<std::uint32_t>(chunkCount * (participant + 1) / participantCount);
+        ranges[participant].packed.store(pack(begin, end), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        busyWorkers = participantCount - 1;
+        ++generation;
+    }
+    workAvailable.notify_all();
+
+    participate(0);
+
+    std::unique_lock lock(mutex);
+    workDone.wait(lock, [&] { return busyWorkers == 0; });
+}
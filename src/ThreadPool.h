@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Fixed-size pool of worker threads running work-stealing parallel loops
+ *
+ * parallelFor() splits an index range into chunks and hands each participant
+ * (the calling thread plus every worker) an equal share up front. A
+ * participant that runs out of chunks steals half of the remaining chunks of
+ * another participant, so uneven per-item cost (e.g. ants crowding near the
+ * nest) still keeps every core busy. Dispatching a loop does not allocate.
+ */
+class ThreadPool {
+private:
+    // Chunk range [begin, end) packed into one word so owner pops and thief
+    // steals are both a single compare-and-swap.
+    struct alignas(64) ChunkRange {
+        std::atomic<std::uint64_t> packed{0};
+    };
+
+    using Body = void (*)(void* context, std::size_t begin, std::size_t end, unsigned int participant);
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<ChunkRange[]> ranges;
+    const unsigned int participantCount;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    std::uint64_t generation = 0;
+    unsigned int busyWorkers = 0;
+    bool stopping = false;
+
+    Body body = nullptr;
+    void* bodyContext = nullptr;
+    std::size_t itemCount = 0;
+    std::size_t grainSize = 1;
+
+    void workerLoop(unsigned int participant);
+    void participate(unsigned int participant);
+    bool popChunk(unsigned int participant, std::uint32_t& chunk);
+    bool stealChunks(unsigned int thief);
+    void run(std::size_t count, std::size_t grain, Body body, void* context);
+
+public:
+    /**
+     * @param threadCount Total threads taking part in a loop, including the caller
+     */
+    explicit ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int getThreadCount() const { return participantCount; }
+
+    /**
+     * @brief Calls fn(begin, end, participant) over [0, count) in chunks of `grain`
+     *
+     * Blocks until every chunk has run. `participant` is in [0, getThreadCount())
+     * and is unique among concurrently running calls, so it can index
+     * per-thread scratch space.
+     */
+    template<typename Fn>
+    void parallelFor(std::size_t count, std::size_t grain, Fn&& fn) {
+        using FnType = std::remove_reference_t<Fn>;
+        run(count, grain, [](void* context, std::size_t begin, std::size_t end, unsigned int participant) {
+            (*static_cast<FnType*>(context))(begin, end, participant);
+        }, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+};
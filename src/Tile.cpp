@@ -1,12 +1,10 @@
-#include <algorithm>
-
 #include "Tile.h"
 
 Tile::Tile(IntegerPosition pos, TerrainType terrain)
     : position(pos),
+      foodAmount(0.0),
       terrain(terrain),
       hasFood(false),
-      foodAmount(0.0),
       isNestEntrance(false) {
 }
 
@@ -26,25 +24,10 @@ float Tile::getFoodAmount() const {
     return foodAmount;
 }
 
-float Tile::getPheromone(PheromoneType type) const {
-    return pheromones[static_cast<std::size_t>(type)];
-}
-
-bool Tile::hasAnyPheromone() const {
-    for (float value : pheromones) {
-        if (value > 0.0f) return true;
-    }
-    return false;
-}
-
 bool Tile::getIsNestEntrance() const {
     return isNestEntrance;
 }
 
-const std::vector<std::shared_ptr<Ant>>& Tile::getAnts() const {
-    return ants;
-}
-
 void Tile::setTerrain(TerrainType newTerrain) {
     terrain = newTerrain;
 }
@@ -62,37 +45,10 @@ void Tile::removeFood(float amount) {
     }
 }
 
-void Tile::depositPheromone(PheromoneType type, float amount) {
-    pheromones[static_cast<std::size_t>(type)] += amount;
-}
-
-void Tile::setPheromone(PheromoneType type, float value) {
-    pheromones[static_cast<std::size_t>(type)] = value;
-}
-
 void Tile::setNestEntrance(bool isEntrance) {
     isNestEntrance = isEntrance;
 }
 
-void Tile::addAnt(std::shared_ptr<Ant> ant) {
-    ants.push_back(ant);
-}
-
-void Tile::removeAnt(std::shared_ptr<Ant> ant) {
-    auto it = std::find(ants.begin(), ants.end(), ant);
-    if (it != ants.end()) {
-        ants.erase(it);
-    }
-}
-
-bool Tile::hasAnts() const {
-    return !ants.empty();
-}
-
-int Tile::getAntCount() const {
-    return ants.size();
-}
-
 std::string Tile::getDescription() const {
     std::string desc = "Tile at " + position.toString() + " - ";
 
@@ -111,13 +67,5 @@ std::string Tile::getDescription() const {
         desc += ", Food: " + std::to_string(foodAmount);
     }
 
-    if (hasAnyPheromone()) {
-        desc += ", FoodTrail: " + std::to_string(getPheromone(PheromoneType::FoodTrail));
-    }
-
-    if (hasAnts()) {
-        desc += ", Ants: " + std::to_string(ants.size());
-    }
-
     return desc;
 }
@@ -0,0 +1,112 @@
+#include <cerrno>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include "AllocationCounter.h"
+#include "TileStore.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ANTS_TILESTORE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::size_t kChunkBytes = TileStore::kChunkArea * sizeof(Tile);
+constexpr std::align_val_t kChunkAlignment{64};
+
+} // namespace
+
+TileStore::TileStore(unsigned int width, unsigned int height, Generator generator,
+                     const std::optional<std::filesystem::path>& backingFile)
+    : width(width),
+      height(height),
+      chunksX((width + kChunkSize - 1) / kChunkSize),
+      generator(std::move(generator)),
+      chunks(static_cast<std::size_t>(chunksX) * ((height + kChunkSize - 1) / kChunkSize)) {
+    if (!backingFile) return;
+#ifdef ANTS_TILESTORE_MMAP
+    backingFd = ::open(backingFile->c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (backingFd < 0) {
+        throw std::system_error(errno, std::generic_category(), "open " + backingFile->string());
+    }
+    ::unlink(backingFile->c_str());
+#else
+    throw std::runtime_error("File-backed tile storage is not supported on this platform");
+#endif
+}
+
+TileStore::~TileStore() {
+    for (auto& chunk : chunks) {
+        if (Tile* tiles = chunk.load(std::memory_order_relaxed)) {
+            std::destroy_n(tiles, kChunkArea);
+            if (backingFd < 0) {
+                ::operator delete(tiles, kChunkAlignment);
+            }
+        }
+    }
+#ifdef ANTS_TILESTORE_MMAP
+    for (const auto& [address, length] : slabs) {
+        ::munmap(address, length);
+    }
+    if (backingFd >= 0) {
+        ::close(backingFd);
+    }
+#endif
+}
+
+std::size_t TileStore::getLoadedChunkCount() const {
+    return loadedChunkCount.load(std::memory_order_acquire);
+}
+
+Tile* TileStore::loadChunk(std::size_t chunk) {
+    std::lock_guard lock(loadMutex);
+    if (Tile* tiles = chunks[chunk].load(std::memory_order_acquire)) {
+        return tiles;
+    }
+
+    allocation_counter::LazyGrowthScope growth;
+    auto* tiles = static_cast<Tile*>(allocateChunkStorage());
+    const unsigned int originX = static_cast<unsigned int>(chunk % chunksX) << kChunkShift;
+    const unsigned int originY = static_cast<unsigned int>(chunk / chunksX) << kChunkShift;
+    for (unsigned int r = 0; r < kChunkSize; ++r) {
+        for (unsigned int c = 0; c < kChunkSize; ++c) {
+            Tile* tile = new (tiles + ((r << kChunkShift) | c)) Tile(IntegerPosition(originX + c, originY + r));
+            if (originX + c < width && originY + r < height) {
+                generator(*tile);
+            }
+        }
+    }
+    chunks[chunk].store(tiles, std::memory_order_release);
+    loadedChunkCount.fetch_add(1, std::memory_order_release);
+    return tiles;
+}
+
+void* TileStore::allocateChunkStorage() {
+    if (backingFd < 0) {
+        return ::operator new(kChunkBytes, kChunkAlignment);
+    }
+#ifdef ANTS_TILESTORE_MMAP
+    if (slabChunksUsed == kChunksPerSlab) {
+        const std::size_t length = kChunksPerSlab * kChunkBytes;
+        const auto offset = static_cast<off_t>(slabs.size() * length);
+        if (::ftruncate(backingFd, offset + static_cast<off_t>(length)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "ftruncate tile backing file");
+        }
+        void* address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, backingFd, offset);
+        if (address == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap tile backing file");
+        }
+        slabs.emplace_back(address, length);
+        slabChunksUsed = 0;
+    }
+    auto* slab = static_cast<std::byte*>(slabs.back().first);
+    return slab + slabChunksUsed++ * kChunkBytes;
+#else
+    throw std::bad_alloc();
+#endif
+}
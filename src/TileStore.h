@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Tile.h"
+
+/**
+ * @brief Tiles stored in kChunkSize x kChunkSize chunks that are loaded on first access
+ *
+ * A chunk nobody has touched has no storage: its tiles are fully described by
+ * the generator, which is run over the chunk the first time any of its tiles
+ * is requested. Memory therefore grows with the explored area of the world,
+ * not with its nominal size.
+ *
+ * Loading is safe from several threads at once (ants running on the thread
+ * pool may walk into new chunks); the tiles themselves are not synchronized.
+ *
+ * Chunk storage comes from the heap by default. With a backing file it is
+ * carved out of shared file mappings instead, so the kernel can write cold
+ * chunks back to disk and drop them from memory when it runs short. The file
+ * is scratch space: it is truncated on construction and unlinked right away.
+ */
+class TileStore {
+public:
+    static constexpr unsigned int kChunkShift = 6;
+    static constexpr unsigned int kChunkSize = 1u << kChunkShift;
+    static constexpr std::size_t kChunkArea = static_cast<std::size_t>(kChunkSize) * kChunkSize;
+
+    // Called for each freshly constructed SOIL tile of a chunk being loaded.
+    using Generator = std::function<void(Tile&)>;
+
+    TileStore(unsigned int width, unsigned int height, Generator generator,
+              const std::optional<std::filesystem::path>& backingFile = std::nullopt);
+    ~TileStore();
+
+    TileStore(const TileStore&) = delete;
+    TileStore& operator=(const TileStore&) = delete;
+
+    // (x, y) must be inside the world. Loads the chunk if needed.
+    Tile& at(unsigned int x, unsigned int y) {
+        const std::size_t chunk = chunkIndex(x, y);
+        Tile* tiles = chunks[chunk].load(std::memory_order_acquire);
+        if (!tiles) {
+            tiles = loadChunk(chunk);
+        }
+        return tiles[offsetInChunk(x, y)];
+    }
+
+    // Null if the chunk holding (x, y) has not been loaded.
+    const Tile* find(unsigned int x, unsigned int y) const {
+        const Tile* tiles = chunks[chunkIndex(x, y)].load(std::memory_order_acquire);
+        return tiles ? tiles + offsetInChunk(x, y) : nullptr;
+    }
+
+    std::size_t getChunkCount() const { return chunks.size(); }
+    unsigned int getChunksX() const { return chunksX; }
+    // All kChunkArea tiles of `chunk`, row-major; loads the chunk if needed.
+    Tile* chunkTiles(std::size_t chunk) {
+        Tile* tiles = chunks[chunk].load(std::memory_order_acquire);
+        return tiles ? tiles : loadChunk(chunk);
+    }
+    // Null if `chunk` has not been loaded.
+    const Tile* findChunk(std::size_t chunk) const { return chunks[chunk].load(std::memory_order_acquire); }
+    std::size_t getLoadedChunkCount() const;
+    bool isFileBacked() const { return backingFd >= 0; }
+
+    // Visits the in-world tiles of every loaded chunk, in chunk order.
+    template <typename Fn>
+    void forEachLoadedTile(Fn&& fn) {
+        for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+            Tile* tiles = chunks[chunk].load(std::memory_order_acquire);
+            if (!tiles) continue;
+            const unsigned int originX = static_cast<unsigned int>(chunk % chunksX) << kChunkShift;
+            const unsigned int originY = static_cast<unsigned int>(chunk / chunksX) << kChunkShift;
+            const unsigned int columns = std::min(kChunkSize, width - originX);
+            const unsigned int rows = std::min(kChunkSize, height - originY);
+            for (unsigned int r = 0; r < rows; ++r) {
+                for (unsigned int c = 0; c < columns; ++c) {
+                    fn(tiles[(r << kChunkShift) | c]);
+                }
+            }
+        }
+    }
+
+private:
+    unsigned int width;
+    unsigned int height;
+    unsigned int chunksX;
+    Generator generator;
+    std::vector<std::atomic<Tile*>> chunks;
+    std::atomic<std::size_t> loadedChunkCount{0};
+    std::mutex loadMutex;
+
+    // File backing: mappings of kChunksPerSlab chunks each, filled in order.
+    static constexpr std::size_t kChunksPerSlab = 64;
+    int backingFd = -1;
+    std::vector<std::pair<void*, std::size_t>> slabs;
+    std::size_t slabChunksUsed = kChunksPerSlab;
+
+    std::size_t chunkIndex(unsigned int x, unsigned int y) const {
+        return static_cast<std::size_t>(y >> kChunkShift) * chunksX + (x >> kChunkShift);
+    }
+    static std::size_t offsetInChunk(unsigned int x, unsigned int y) {
+        return ((y & (kChunkSize - 1)) << kChunkShift) | (x & (kChunkSize - 1));
+    }
+
+    Tile* loadChunk(std::size_t chunk);
+    void* allocateChunkStorage();
+};
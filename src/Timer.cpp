@@ -1,7 +1,16 @@
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 
 #include "Timer.h"
 
+Timer::Timer(float simulationStepsPerSecond, float targetFrameRate)
+    : lastSimulationUpdate(Clock::now()),
+      lastFrameTime(lastSimulationUpdate),
+      simulationStepSize(1.0f / simulationStepsPerSecond),
+      frameBudget(1.0f / targetFrameRate) {
+}
+
 // Time since last frame (for FPS calculations)
 float Timer::getFrameDeltaTime() {
     TimePoint now = Clock::now();
@@ -14,26 +23,86 @@ float Timer::getFrameDeltaTime() {
 int Timer::getSimulationStepsToRun() {
     TimePoint now = Clock::now();
     Duration elapsed = now - lastSimulationUpdate;
-    float elapsedSeconds = elapsed.count();
-    accumulatedTime += elapsedSeconds;
-    int steps = static_cast<int>(accumulatedTime / simulationStepSize);
-    
-    if (steps > 0) {
-        // Calculate exact time to advance
-        accumulatedTime -= steps * simulationStepSize;
-        
-        // Add the duration to the last update time using the + operator
-        lastSimulationUpdate = now;
+    lastSimulationUpdate = now;
+
+    // Until a step has been timed, run one at a time to measure it.
+    const int budgetSteps = stepCost > 0.0f ? std::max(1, static_cast<int>(frameBudget / stepCost)) : 1;
+    if (runMode == RunMode::AsFastAsPossible) {
+        accumulatedTime = 0.0f;
+        return budgetSteps;
+    }
+
+    accumulatedTime += elapsed.count() * (runMode == RunMode::Multiplier ? multiplier : 1.0f);
+    // Compare in float so a long stall cannot overflow the step count.
+    const float dueSteps = std::floor(accumulatedTime / simulationStepSize);
+    int steps = static_cast<int>(std::min(dueSteps, static_cast<float>(budgetSteps)));
+    if (dueSteps > steps) {
+        // Instead of a spiral of death, skip what does not fit and say so.
+        const float skipped = (dueSteps - steps) * simulationStepSize;
+        droppedTime += skipped;
+        accumulatedTime -= skipped;
+    }
+    accumulatedTime -= steps * simulationStepSize;
+    return steps;
+}
+
+void Timer::recordSimulationTime(int steps, float seconds) {
+    if (steps <= 0) return;
+    const float sample = seconds / steps;
+    stepCost = stepCost > 0.0f ? stepCost * 0.9f + sample * 0.1f : sample;
+}
+
+void Timer::setRunMode(RunMode mode, float newMultiplier) {
+    if (mode != runMode) {
+        accumulatedTime = 0.0f;
     }
-    
-    // Limit max steps to prevent spiral of death
-    return std::min(steps, 5);
+    runMode = mode;
+    multiplier = newMultiplier;
+}
+
+RunMode Timer::getRunMode() const {
+    return runMode;
+}
+
+float Timer::getMultiplier() const {
+    return multiplier;
 }
 
-float Timer::getAccumulatedTime() const { 
-    return accumulatedTime; 
+float Timer::getAccumulatedTime() const {
+    return accumulatedTime;
 }
 
 float Timer::getSimulationStepSize() const {
     return simulationStepSize;
-}
\ No newline at end of file
+}
+
+float Timer::getWallClockStepSize() const {
+    switch (runMode) {
+        case RunMode::RealTime:         return simulationStepSize;
+        case RunMode::Multiplier:       return simulationStepSize / multiplier;
+        case RunMode::AsFastAsPossible: return 0.0f;
+    }
+    return simulationStepSize;
+}
+
+float Timer::getTimeUntilNextStep() const {
+    const float remaining = std::max(0.0f, simulationStepSize - accumulatedTime);
+    switch (runMode) {
+        case RunMode::RealTime:         return remaining;
+        case RunMode::Multiplier:       return remaining / multiplier;
+        case RunMode::AsFastAsPossible: return 0.0f;
+    }
+    return remaining;
+}
+
+float Timer::getInterpolation() const {
+    return runMode == RunMode::AsFastAsPossible ? 1.0f : accumulatedTime / simulationStepSize;
+}
+
+float Timer::getStepCost() const {
+    return stepCost;
+}
+
+float Timer::getDroppedTime() const {
+    return droppedTime;
+}
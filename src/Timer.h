@@ -2,45 +2,86 @@
 
 #include <chrono>
 
+/**
+ * @brief How simulated time relates to wall-clock time
+ */
+enum class RunMode {
+    RealTime,         // simulationStepsPerSecond ticks per second
+    Multiplier,       // that rate times the multiplier
+    AsFastAsPossible, // as many ticks as fit in each frame
+};
+
 /**
  * @brief Timer class for managing simulation and rendering timing
- * 
+ *
  * This class helps decouple simulation updates from rendering frames,
  * allowing fixed-time simulation steps while rendering at maximum speed.
+ *
+ * The number of steps per frame is limited by the frame budget rather than a
+ * fixed cap: the timer keeps a running average of what a step costs (from
+ * recordSimulationTime()) and never hands out more steps than fit in one
+ * frame at the target frame rate. Steps that were due but did not fit are
+ * dropped and their simulated time is added to getDroppedTime().
  */
 class Timer {
 private:
-    using Clock = std::chrono::high_resolution_clock;
+    using Clock = std::chrono::steady_clock;
     using TimePoint = Clock::time_point;
     using Duration = std::chrono::duration<float>;
-    
+
     TimePoint lastSimulationUpdate;  // Time of last simulation update
     TimePoint lastFrameTime;         // Time of last frame render
     float simulationStepSize;        // Fixed timestep size in seconds
+    float frameBudget;               // Seconds per frame at the target frame rate
+    RunMode runMode = RunMode::RealTime;
+    float multiplier = 1.0f;
     float accumulatedTime = 0.0f;
-    
+    float stepCost = 0.0f;           // Running average of seconds per step
+    float droppedTime = 0.0f;
+
 public:
     /**
      * @brief Construct a new Timer object
-     * 
+     *
      * @param simulationStepsPerSecond How many simulation steps per second (default: 10)
+     * @param targetFrameRate Frames per second the step budget is sized for (default: 60)
      */
-    Timer(float simulationStepsPerSecond = 10.0f) : simulationStepSize(1.0f / simulationStepsPerSecond) {}
-    
+    Timer(float simulationStepsPerSecond = 10.0f, float targetFrameRate = 60.0f);
+
     /**
      * @brief Get time elapsed since last frame
-     * 
+     *
      * @return float Time in seconds since last call to this method
      */
     float getFrameDeltaTime();
-    
+
     /**
-     * @brief Calculate how many simulation steps should be run
-     * 
-     * @return int Number of simulation steps to run (capped at 5)
+     * @brief Calculate how many simulation steps should run now
+     *
+     * @return int Steps due in this run mode, at most as many as fit in the
+     *         frame budget (at least one while the step cost is unknown)
      */
     int getSimulationStepsToRun();
 
+    /**
+     * @brief Report how long the last batch of steps took
+     */
+    void recordSimulationTime(int steps, float seconds);
+
+    void setRunMode(RunMode mode, float newMultiplier = 1.0f);
+    RunMode getRunMode() const;
+    float getMultiplier() const;
+
     float getAccumulatedTime() const;
     float getSimulationStepSize() const;
-};
\ No newline at end of file
+    // Wall-clock seconds between steps in the current mode; 0 when running
+    // as fast as possible.
+    float getWallClockStepSize() const;
+    // Wall-clock seconds until the next step is due.
+    float getTimeUntilNextStep() const;
+    // Fraction of the way to the next step, for interpolation.
+    float getInterpolation() const;
+    float getStepCost() const;
+    // Simulated seconds skipped because the steps did not fit in a frame.
+    float getDroppedTime() const;
+};
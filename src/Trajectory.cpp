@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "Trajectory.h"
+#include "World.h"
+
+using namespace trajectory;
+
+namespace {
+
+constexpr float kPositionScale = static_cast<float>(1u << kPositionShift);
+
+std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// Worst case for a 64-bit value.
+constexpr std::size_t kMaxVarintBytes = 10;
+
+std::uint8_t* putVarint(std::uint8_t* out, std::uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<std::uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<std::uint8_t>(value);
+    return out;
+}
+
+// Positions and loads are never negative, so rounding is a biased truncation.
+std::int32_t quantize(float value, float scale) {
+    return static_cast<std::int32_t>(value * scale + 0.5f);
+}
+
+} // namespace
+
+TrajectoryRecorder::TrajectoryRecorder(const std::filesystem::path& path, const World& world,
+                                       unsigned int ticksPerBlock)
+    : ticksPerBlock(std::max(1u, ticksPerBlock)),
+      out(path, std::ios::binary | std::ios::trunc) {
+    if (!out) throw std::runtime_error("Cannot open " + path.string() + " for writing");
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.positionShift = kPositionShift;
+    header.width = world.width;
+    header.height = world.height;
+    header.seed = world.getSeed();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytesWritten = sizeof(header);
+    writer = std::thread([this] { writerLoop(); });
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    try {
+        finish();
+    } catch (...) {
+        // Errors can only be reported by calling finish() explicitly.
+    }
+}
+
+void TrajectoryRecorder::record(const World& world) {
+    const AntStore& ants = world.getAnts();
+    const std::size_t antCount = ants.size();
+    if (filling->tickCount > 0 &&
+        (filling->tickCount == ticksPerBlock || filling->ids.size() != antCount ||
+         filling->firstTick + filling->tickCount != world.getTick())) {
+        handOff();
+    }
+    if (filling->tickCount == 0) {
+        filling->firstTick = world.getTick();
+        filling->ids.assign(ants.ids.begin(), ants.ids.end());
+        filling->roles.assign(ants.roles.begin(), ants.roles.end());
+        filling->samples.clear();
+        filling->samples.reserve(antCount * ticksPerBlock);
+    }
+
+    const std::size_t offset = filling->samples.size();
+    filling->samples.resize(offset + antCount);
+    RawSample* samples = filling->samples.data() + offset;
+    for (std::size_t i = 0; i < antCount; ++i) {
+        float load = 0.0f;
+        for (const float amount : ants.carriedItems[i]) {
+            load += amount;
+        }
+        samples[i] = {
+            quantize(ants.positions[i].getX(), kPositionScale),
+            quantize(ants.positions[i].getY(), kPositionScale),
+            quantize(load, kLoadScale),
+        };
+    }
+    ++filling->tickCount;
+}
+
+void TrajectoryRecorder::handOff() {
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [this] { return spare != nullptr; });
+    pending = filling;
+    filling = spare;
+    spare = nullptr;
+    filling->tickCount = 0;
+    changed.notify_all();
+}
+
+void TrajectoryRecorder::writerLoop() {
+    std::unique_lock lock(mutex);
+    for (;;) {
+        changed.wait(lock, [this] { return pending != nullptr || stopping; });
+        if (!pending) return;
+        Batch* batch = pending;
+        pending = nullptr;
+        lock.unlock();
+        writeBlock(*batch);
+        lock.lock();
+        spare = batch;
+        changed.notify_all();
+    }
+}
+
+void TrajectoryRecorder::writeBlock(const Batch& batch) {
+    const std::size_t antCount = batch.ids.size();
+    // Grown to the worst case once and never shrunk or cleared.
+    const std::size_t bound = (4 * kMaxVarintBytes + 1) * antCount * batch.tickCount;
+    if (encoded.size() < bound) {
+        encoded.resize(bound);
+    }
+    std::uint8_t* cursor = encoded.data();
+    for (std::size_t i = 0; i < antCount; ++i) {
+        const RawSample& sample = batch.samples[i];
+        cursor = putVarint(cursor, zigzag(batch.ids[i]));
+        *cursor++ = static_cast<std::uint8_t>(batch.roles[i]);
+        cursor = putVarint(cursor, zigzag(sample.x));
+        cursor = putVarint(cursor, zigzag(sample.y));
+        cursor = putVarint(cursor, zigzag(sample.load));
+    }
+    for (std::uint32_t t = 1; t < batch.tickCount; ++t) {
+        const RawSample* previous = batch.samples.data() + (t - 1) * antCount;
+        const RawSample* current = previous + antCount;
+        for (std::size_t i = 0; i < antCount; ++i) {
+            cursor = putVarint(cursor, zigzag(std::int64_t{current[i].x} - previous[i].x));
+            cursor = putVarint(cursor, zigzag(std::int64_t{current[i].y} - previous[i].y));
+            cursor = putVarint(cursor, zigzag(std::int64_t{current[i].load} - previous[i].load));
+        }
+    }
+    const auto payloadBytes = static_cast<std::uint64_t>(cursor - encoded.data());
+
+    const BlockHeader header{
+        .firstTick = batch.firstTick,
+        .tickCount = batch.tickCount,
+        .antCount = static_cast<std::uint32_t>(antCount),
+        .payloadBytes = payloadBytes,
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(payloadBytes));
+
+    std::lock_guard lock(mutex);
+    if (!out && error.empty()) {
+        error = "Failed to write trajectory block";
+    }
+    index.push_back({ .firstTick = header.firstTick, .offset = bytesWritten,
+                      .tickCount = header.tickCount, .antCount = header.antCount });
+    bytesWritten += sizeof(header) + payloadBytes;
+}
+
+void TrajectoryRecorder::finish() {
+    if (finished) return;
+    finished = true;
+    if (filling->tickCount > 0) {
+        handOff();
+    }
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+
+    Footer footer{};
+    footer.indexOffset = bytesWritten;
+    footer.blockCount = index.size();
+    std::memcpy(footer.magic, kFooterMagic, sizeof(kFooterMagic));
+    out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexEntry)));
+    out.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    bytesWritten += index.size() * sizeof(IndexEntry) + sizeof(footer);
+    out.close();
+    if (!error.empty()) throw std::runtime_error(error);
+    if (!out) throw std::runtime_error("Failed to write trajectory index");
+}
+
+std::uint64_t TrajectoryRecorder::getBytesWritten() const {
+    std::lock_guard lock(mutex);
+    return bytesWritten;
+}
+
+TrajectoryReader::TrajectoryReader(const std::filesystem::path& path) : in(path, std::ios::binary) {
+    if (!in) throw std::runtime_error("Cannot open trajectory " + path.string());
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error(path.string() + " is not a trajectory file");
+    }
+    if (header.version != kFormatVersion || header.positionShift != kPositionShift) {
+        throw std::runtime_error(path.string() + " has unsupported trajectory version " + std::to_string(header.version));
+    }
+
+    in.seekg(0, std::ios::end);
+    const auto fileSize = static_cast<std::uint64_t>(in.tellg());
+    Footer footer{};
+    if (fileSize >= sizeof(header) + sizeof(footer)) {
+        in.seekg(static_cast<std::streamoff>(fileSize - sizeof(footer)));
+        in.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+    }
+    const bool indexed = in && std::memcmp(footer.magic, kFooterMagic, sizeof(kFooterMagic)) == 0 &&
+                         footer.indexOffset + footer.blockCount * sizeof(IndexEntry) + sizeof(footer) == fileSize;
+    if (indexed) {
+        index.resize(footer.blockCount);
+        in.seekg(static_cast<std::streamoff>(footer.indexOffset));
+        in.read(reinterpret_cast<char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexEntry)));
+    } else {
+        in.clear();
+        buildIndexByScanning();
+    }
+}
+
+void TrajectoryReader::buildIndexByScanning() {
+    // No usable footer (recording was cut short): walk the block headers and
+    // keep every block that was written completely.
+    in.seekg(0, std::ios::end);
+    const auto fileSize = static_cast<std::uint64_t>(in.tellg());
+    std::uint64_t offset = sizeof(FileHeader);
+    BlockHeader block{};
+    while (offset + sizeof(block) <= fileSize) {
+        in.seekg(static_cast<std::streamoff>(offset));
+        if (!in.read(reinterpret_cast<char*>(&block), sizeof(block))) break;
+        if (block.tickCount == 0 || offset + sizeof(block) + block.payloadBytes > fileSize) break;
+        if (!index.empty() && block.firstTick < index.back().firstTick + index.back().tickCount) break;
+        index.push_back({ .firstTick = block.firstTick, .offset = offset,
+                          .tickCount = block.tickCount, .antCount = block.antCount });
+        offset += sizeof(block) + block.payloadBytes;
+    }
+    in.clear();
+}
+
+std::uint64_t TrajectoryReader::getFirstTick() const {
+    return index.empty() ? 0 : index.front().firstTick;
+}
+
+std::uint64_t TrajectoryReader::getEndTick() const {
+    return index.empty() ? 0 : index.back().firstTick + index.back().tickCount;
+}
+
+void TrajectoryReader::loadBlock(std::size_t number) {
+    const IndexEntry& entry = index[number];
+    BlockHeader block{};
+    in.seekg(static_cast<std::streamoff>(entry.offset));
+    in.read(reinterpret_cast<char*>(&block), sizeof(block));
+    payload.resize(block.payloadBytes);
+    in.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    if (!in || block.firstTick != entry.firstTick || block.antCount != entry.antCount) {
+        throw std::runtime_error("Corrupt trajectory block at tick " + std::to_string(entry.firstTick));
+    }
+    cursor = 0;
+    tickInBlock = 0;
+    blockLoaded = true;
+    ids.resize(block.antCount);
+    roles.resize(block.antCount);
+    fixedX.resize(block.antCount);
+    fixedY.resize(block.antCount);
+    fixedLoad.resize(block.antCount);
+}
+
+std::uint64_t TrajectoryReader::readVarint() {
+    std::uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        if (cursor >= payload.size()) throw std::runtime_error("Truncated trajectory block");
+        const std::uint8_t byte = payload[cursor++];
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw std::runtime_error("Malformed varint in trajectory block");
+}
+
+void TrajectoryReader::decodeTick() {
+    if (tickInBlock == 0) {
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            ids[i] = static_cast<int>(unzigzag(readVarint()));
+            if (cursor >= payload.size()) throw std::runtime_error("Truncated trajectory block");
+            roles[i] = static_cast<AntRole>(payload[cursor++]);
+            fixedX[i] = unzigzag(readVarint());
+            fixedY[i] = unzigzag(readVarint());
+            fixedLoad[i] = unzigzag(readVarint());
+        }
+    } else {
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            fixedX[i] += unzigzag(readVarint());
+            fixedY[i] += unzigzag(readVarint());
+            fixedLoad[i] += unzigzag(readVarint());
+        }
+    }
+    ++tickInBlock;
+}
+
+void TrajectoryReader::seek(std::uint64_t tick) {
+    if (index.empty()) return;
+    tick = std::clamp(tick, getFirstTick(), getEndTick() - 1);
+    const auto next = std::upper_bound(index.begin(), index.end(), tick,
+                                       [](std::uint64_t t, const IndexEntry& entry) { return t < entry.firstTick; });
+    blockNumber = static_cast<std::size_t>(next - index.begin()) - 1;
+    loadBlock(blockNumber);
+    // A gap between blocks lands on the start of the following block.
+    const std::uint64_t skip = std::min<std::uint64_t>(tick - index[blockNumber].firstTick, index[blockNumber].tickCount);
+    for (std::uint64_t t = 0; t < skip; ++t) {
+        decodeTick();
+    }
+}
+
+bool TrajectoryReader::readFrame(Frame& frame) {
+    for (;;) {
+        if (blockNumber >= index.size()) return false;
+        if (!blockLoaded) loadBlock(blockNumber);
+        if (tickInBlock < index[blockNumber].tickCount) break;
+        ++blockNumber;
+        blockLoaded = false;
+    }
+    frame.tick = index[blockNumber].firstTick + tickInBlock;
+    decodeTick();
+    frame.ants.resize(ids.size());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        frame.ants[i] = {
+            .id = ids[i],
+            .role = roles[i],
+            .x = static_cast<float>(fixedX[i]) / kPositionScale,
+            .y = static_cast<float>(fixedY[i]) / kPositionScale,
+            .load = static_cast<float>(fixedLoad[i]) / kLoadScale,
+        };
+    }
+    return true;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Ant.h"
+
+class World;
+
+/**
+ * @brief Compact on-disk format for per-tick ant trajectories
+ *
+ * A file is a FileHeader, a sequence of blocks and, once recording finished
+ * cleanly, a block index followed by a Footer. Each block covers a run of
+ * consecutive ticks with a fixed set of ants: the first tick is a key frame
+ * (id, role, absolute position and load of every ant), every later tick
+ * stores per-ant differences from the tick before. Positions are fixed point
+ * with kPositionShift fractional bits and loads are in 1/kLoadScale units;
+ * all values are zigzag varints, so an ant that moves about one tile per tick
+ * costs about five bytes.
+ *
+ * Seeking decodes at most one block: find the last block starting at or
+ * before the tick in the index, then step forward from its key frame. Files
+ * without an index (e.g. after a crash) can still be read by scanning the
+ * block headers.
+ */
+namespace trajectory {
+
+inline constexpr char kMagic[8] = {'A', 'N', 'T', 'T', 'R', 'A', 'J', '\0'};
+inline constexpr char kFooterMagic[8] = {'A', 'N', 'T', 'T', 'I', 'D', 'X', '\0'};
+inline constexpr std::uint32_t kFormatVersion = 1;
+inline constexpr unsigned int kPositionShift = 8;
+inline constexpr float kLoadScale = 16.0f;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t positionShift;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t seed;
+    std::uint32_t reserved;
+};
+
+struct BlockHeader {
+    std::uint64_t firstTick;
+    std::uint32_t tickCount;
+    std::uint32_t antCount;
+    std::uint64_t payloadBytes;
+};
+
+struct IndexEntry {
+    std::uint64_t firstTick;
+    std::uint64_t offset; // of the BlockHeader
+    std::uint32_t tickCount;
+    std::uint32_t antCount;
+};
+
+struct Footer {
+    std::uint64_t indexOffset;
+    std::uint64_t blockCount;
+    char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 32);
+static_assert(sizeof(BlockHeader) == 24);
+static_assert(sizeof(IndexEntry) == 24);
+static_assert(sizeof(Footer) == 24);
+
+struct AntSample {
+    int id;
+    AntRole role;
+    float x;
+    float y;
+    float load;
+};
+
+struct Frame {
+    std::uint64_t tick = 0;
+    std::vector<AntSample> ants;
+};
+
+} // namespace trajectory
+
+/**
+ * @brief Records every ant's position, role and carried load once per tick
+ *
+ * Call record() after each World::update(). The tick thread only copies the
+ * raw ant state into the batch being filled; a background thread encodes
+ * and writes full batches. There are two batches, so recording stalls the
+ * tick only if the writer falls a whole block behind.
+ *
+ * A new block starts every ticksPerBlock ticks or when the number of ants
+ * changes (adding ants may reorder them).
+ */
+class TrajectoryRecorder {
+public:
+    TrajectoryRecorder(const std::filesystem::path& path, const World& world, unsigned int ticksPerBlock = 64);
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    void record(const World& world);
+    // Flushes the last block and writes the index. Throws std::runtime_error
+    // if any write failed. Called by the destructor if not called before.
+    void finish();
+
+    std::uint64_t getBytesWritten() const;
+
+private:
+    // Already quantized, so the writer thread only does deltas and varints.
+    struct RawSample {
+        std::int32_t x;
+        std::int32_t y;
+        std::int32_t load;
+    };
+
+    struct Batch {
+        std::uint64_t firstTick = 0;
+        std::uint32_t tickCount = 0;
+        std::vector<int> ids;
+        std::vector<AntRole> roles;
+        std::vector<RawSample> samples; // tickCount runs of ids.size() samples
+    };
+
+    const unsigned int ticksPerBlock;
+    std::ofstream out;
+    Batch batches[2];
+    Batch* filling = &batches[0];
+    Batch* spare = &batches[1];
+    Batch* pending = nullptr;
+
+    // Writer thread state, guarded by mutex.
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping = false;
+    bool finished = false;
+    std::string error;
+    std::uint64_t bytesWritten = 0;
+    std::vector<trajectory::IndexEntry> index;
+    std::vector<std::uint8_t> encoded; // writer thread only
+
+    std::thread writer;
+
+    void handOff();
+    void writerLoop();
+    void writeBlock(const Batch& batch);
+};
+
+/**
+ * @brief Sequential and random access over a recorded trajectory file
+ */
+class TrajectoryReader {
+public:
+    explicit TrajectoryReader(const std::filesystem::path& path);
+
+    const trajectory::FileHeader& getHeader() const { return header; }
+    std::uint64_t getFirstTick() const;
+    // One past the last recorded tick.
+    std::uint64_t getEndTick() const;
+
+    // The next readFrame() returns `tick` (clamped to the recorded range).
+    void seek(std::uint64_t tick);
+    // Returns false at the end of the recording.
+    bool readFrame(trajectory::Frame& frame);
+
+private:
+    std::ifstream in;
+    trajectory::FileHeader header{};
+    std::vector<trajectory::IndexEntry> index;
+
+    // Decoding state of the current block.
+    std::size_t blockNumber = 0;
+    bool blockLoaded = false;
+    std::uint32_t tickInBlock = 0;
+    std::vector<std::uint8_t> payload;
+    std::size_t cursor = 0;
+    std::vector<int> ids;
+    std::vector<AntRole> roles;
+    std::vector<std::int64_t> fixedX;
+    std::vector<std::int64_t> fixedY;
+    std::vector<std::int64_t> fixedLoad;
+
+    void buildIndexByScanning();
+    void loadBlock(std::size_t number);
+    void decodeTick();
+    std::uint64_t readVarint();
+};
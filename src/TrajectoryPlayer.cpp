@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+
+#include "TrajectoryPlayer.h"
+
+TrajectoryPlayer::TrajectoryPlayer(const std::filesystem::path& path, std::size_t lookahead)
+    : ring(std::max<std::size_t>(2, lookahead)) {
+    TrajectoryReader reader(path);
+    header = reader.getHeader();
+    firstTick = reader.getFirstTick();
+    endTick = reader.getEndTick();
+    position = static_cast<double>(firstTick);
+    reader.seek(firstTick);
+    decoder = std::thread([this, reader = std::move(reader)]() mutable { decodeLoop(std::move(reader)); });
+}
+
+TrajectoryPlayer::~TrajectoryPlayer() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    decoder.join();
+}
+
+void TrajectoryPlayer::decodeLoop(TrajectoryReader reader) {
+    std::uint64_t activeGeneration = 0;
+    bool atEnd = false;
+    std::unique_lock lock(mutex);
+    for (;;) {
+        changed.wait(lock, [&] {
+            return stopping || generation != activeGeneration || (!atEnd && count < ring.size());
+        });
+        if (stopping) return;
+
+        if (generation != activeGeneration) {
+            activeGeneration = generation;
+            atEnd = false;
+            const std::uint64_t tick = seekTick;
+            lock.unlock();
+            reader.seek(tick);
+            lock.lock();
+            continue;
+        }
+
+        // The slot past the last decoded frame is never read by the render
+        // thread, so it can be filled without holding the lock.
+        trajectory::Frame& slot = ring[(head + count) % ring.size()];
+        lock.unlock();
+        bool decoded;
+        try {
+            decoded = reader.readFrame(slot);
+        } catch (const std::exception&) {
+            decoded = false; // a damaged tail ends playback like a short file
+        }
+        lock.lock();
+        if (generation != activeGeneration) continue;
+        if (!decoded) {
+            atEnd = true;
+            continue;
+        }
+        ++count;
+    }
+}
+
+void TrajectoryPlayer::seek(double tick) {
+    if (endTick <= firstTick) return;
+    position = std::clamp(tick, static_cast<double>(firstTick), static_cast<double>(endTick - 1));
+    {
+        std::lock_guard lock(mutex);
+        count = 0;
+        seekTick = static_cast<std::uint64_t>(position);
+        ++generation;
+    }
+    changed.notify_all();
+}
+
+void TrajectoryPlayer::advance(double seconds) {
+    if (!playing || endTick <= firstTick) return;
+    position += seconds * speed;
+    const auto last = static_cast<double>(endTick - 1);
+    if (position >= last) {
+        position = last;
+        playing = false;
+    }
+
+    // Release frames the position has moved past. If the decoder has fallen
+    // more than a ring behind (very high speed), jump it forward instead of
+    // letting it decode every frame in between.
+    const auto tick = static_cast<std::uint64_t>(position);
+    bool reseek = false;
+    {
+        std::lock_guard lock(mutex);
+        while (count >= 2 && ring[(head + 1) % ring.size()].tick <= tick) {
+            head = (head + 1) % ring.size();
+            --count;
+        }
+        reseek = count > 0 && ring[head].tick + ring.size() < tick;
+    }
+    if (reseek) {
+        seek(position);
+    } else {
+        changed.notify_all();
+    }
+}
+
+TrajectoryPlayer::FramePair TrajectoryPlayer::currentFrames() {
+    const auto tick = static_cast<std::uint64_t>(position);
+    std::lock_guard lock(mutex);
+    if (count == 0 || ring[head].tick > tick) return {};
+
+    FramePair frames;
+    frames.previous = &ring[head];
+    if (count >= 2) {
+        const trajectory::Frame& following = ring[(head + 1) % ring.size()];
+        if (following.tick == frames.previous->tick + 1) {
+            frames.next = &following;
+        }
+    }
+    frames.interpolation = static_cast<float>(std::clamp(position - static_cast<double>(frames.previous->tick), 0.0, 1.0));
+    return frames;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Trajectory.h"
+
+/**
+ * @brief Plays back a recorded trajectory with play/pause, scrubbing and speed control
+ *
+ * A background thread decodes frames ahead of the playback position into a
+ * fixed ring of reusable frames, so the render thread only picks the two
+ * frames around the current position and interpolates between them.
+ * Seeking flushes the ring and restarts decoding from the nearest block.
+ *
+ * Everything except the decoder thread must be called from one thread.
+ * Frames returned by currentFrames() stay valid until the next call to
+ * advance(), seek() or currentFrames().
+ */
+class TrajectoryPlayer {
+public:
+    struct FramePair {
+        const trajectory::Frame* previous = nullptr; // at or before the position
+        const trajectory::Frame* next = nullptr;     // the tick after, if decoded
+        float interpolation = 0.0f;                  // position between the two
+    };
+
+    explicit TrajectoryPlayer(const std::filesystem::path& path, std::size_t lookahead = 256);
+    ~TrajectoryPlayer();
+
+    TrajectoryPlayer(const TrajectoryPlayer&) = delete;
+    TrajectoryPlayer& operator=(const TrajectoryPlayer&) = delete;
+
+    const trajectory::FileHeader& getHeader() const { return header; }
+    std::uint64_t getFirstTick() const { return firstTick; }
+    std::uint64_t getEndTick() const { return endTick; }
+
+    bool isPlaying() const { return playing; }
+    void setPlaying(bool play) { playing = play; }
+    // Playback speed in recorded ticks per wall-clock second.
+    double getSpeed() const { return speed; }
+    void setSpeed(double ticksPerSecond) { speed = ticksPerSecond; }
+
+    double getPosition() const { return position; }
+    void seek(double tick);
+    // Moves the playback position forward by `seconds` of wall-clock time
+    // if playing. Playback pauses at the end of the recording.
+    void advance(double seconds);
+
+    // Empty if the decoder has not caught up with the position yet.
+    FramePair currentFrames();
+
+private:
+    trajectory::FileHeader header{};
+    std::uint64_t firstTick = 0;
+    std::uint64_t endTick = 0;
+    bool playing = true;
+    double speed = 30.0;
+    double position = 0.0;
+
+    // Ring of decoded frames in tick order: [head, head + count).
+    std::vector<trajectory::Frame> ring;
+    std::size_t head = 0;
+    std::size_t count = 0;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::uint64_t generation = 0; // bumped by seek() to restart decoding
+    std::uint64_t seekTick = 0;
+    bool stopping = false;
+    std::thread decoder;
+
+    void decodeLoop(TrajectoryReader reader);
+};
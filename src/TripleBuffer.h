@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free single-producer, single-consumer triple buffer
+ *
+ * The writer fills writeBuffer() and publish()es it; the reader acquire()s
+ * the most recently published buffer and reads it until its next acquire().
+ * Neither side ever waits: the writer always has a buffer the reader is not
+ * using, and a reader that falls behind simply skips to the latest state.
+ *
+ * Buffers are recycled, so a writer refilling one in place (reusing vector
+ * capacity) stops allocating once all three have grown.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    T& writeBuffer() { return buffers[writeIndex]; }
+
+    void publish() {
+        writeIndex = middle.exchange(writeIndex | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Switches to the latest published buffer. Returns false (and keeps the
+    // current one) if nothing was published since the last acquire().
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & kFresh)) return false;
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    const T& readBuffer() const { return buffers[readIndex]; }
+
+private:
+    static constexpr std::uint8_t kIndexMask = 0x3;
+    static constexpr std::uint8_t kFresh = 0x4;
+
+    std::array<T, 3> buffers{};
+    std::uint8_t writeIndex = 0;              // writer only
+    std::atomic<std::uint8_t> middle{1};      // index of the spare buffer, plus kFresh
+    std::uint8_t readIndex = 2;               // reader only
+};
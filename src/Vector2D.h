@@ -1,50 +1,63 @@
 #pragma once
 
 #include <cmath>
+#include <type_traits>
 
+/**
+ * @brief Plain 2D float vector; trivially copyable, constexpr arithmetic
+ */
 class Vector2D {
 public:
+    // normalized() returns the zero vector below this magnitude.
+    static constexpr float kNormalizeEpsilon = 0.00001f;
+
     float x;
     float y;
 
     // Constructors
-    Vector2D() : x(0.0f), y(0.0f) {}
-    Vector2D(float x, float y) : x(x), y(y) {}
+    constexpr Vector2D() : x(0.0f), y(0.0f) {}
+    constexpr Vector2D(float x, float y) : x(x), y(y) {}
 
     // Vector operations
-    Vector2D operator+(const Vector2D& other) const {
+    constexpr Vector2D operator+(const Vector2D& other) const {
         return Vector2D(x + other.x, y + other.y);
     }
 
-    Vector2D operator-(const Vector2D& other) const {
+    constexpr Vector2D operator-(const Vector2D& other) const {
         return Vector2D(x - other.x, y - other.y);
     }
 
-    Vector2D operator*(float scalar) const {
+    constexpr Vector2D operator*(float scalar) const {
         return Vector2D(x * scalar, y * scalar);
     }
 
-    Vector2D operator-() const {
+    constexpr Vector2D operator-() const {
         return Vector2D(-x, -y);
     }
 
     // Utility methods
+    constexpr float squaredMagnitude() const {
+        return x*x + y*y;
+    }
+
     float magnitude() const {
         return std::sqrt(x*x + y*y);
     }
 
     Vector2D normalized() const {
         float mag = magnitude();
-        if (mag < 0.00001f) return Vector2D(0, 0);
+        if (mag < kNormalizeEpsilon) return Vector2D(0, 0);
         return Vector2D(x / mag, y / mag);
     }
 
-    float dot(const Vector2D& other) const {
+    constexpr float dot(const Vector2D& other) const {
         return x * other.x + y * other.y;
     }
 };
 
 // Non-member operator
-inline Vector2D operator*(float scalar, const Vector2D& vector) {
+constexpr Vector2D operator*(float scalar, const Vector2D& vector) {
     return vector * scalar;
-}
\ No newline at end of file
+}
+
+static_assert(sizeof(Vector2D) == 8 && std::is_trivially_copyable_v<Vector2D>);
@@ -1,20 +1,99 @@
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
 #include <vector>
 #include "Position.h"
 #include "Visualizer.h"
 #include "World.h"
 
+namespace {
+
+sf::Color colorForRole(AntRole role) {
+    switch (role) {
+        case AntRole::QUEEN:   return sf::Color::Yellow;
+        case AntRole::WORKER:  return sf::Color::Black;
+        case AntRole::SOLDIER: return sf::Color::Red;
+        case AntRole::DRONE:   return sf::Color::Cyan;
+        case AntRole::FORAGER: return sf::Color::Blue;
+        case AntRole::NURSE:   return sf::Color::Green;
+    }
+    return sf::Color::White;
+}
+
+const sf::Color defaultTerrainColor(169, 169, 169); // Dark Gray
+
+const PheromoneOverlay::ColorMap trailColorMap{ 80, 180, 255, 6.0f, 200.0f };
+
+sf::Color colorForTerrain(TerrainType terrain) {
+    switch (terrain) {
+        case TerrainType::GRASS: return sf::Color(34, 139, 34);   // Forest Green
+        case TerrainType::ROCK:  return sf::Color(128, 128, 128); // Gray
+        case TerrainType::SAND:  return sf::Color(238, 214, 175); // Sandy Brown
+        case TerrainType::SOIL:  return sf::Color(200, 200, 150); // Soil brown
+    }
+    return defaultTerrainColor;
+}
+
+// Two triangles, so every quad of a layer can share one draw call.
+void appendQuad(sf::VertexArray& vertices, sf::Vector2f topLeft, sf::Vector2f size, sf::Color color) {
+    const sf::Vector2f topRight = topLeft + sf::Vector2f(size.x, 0.0f);
+    const sf::Vector2f bottomLeft = topLeft + sf::Vector2f(0.0f, size.y);
+    const sf::Vector2f bottomRight = topLeft + size;
+    vertices.append({topLeft, color});
+    vertices.append({topRight, color});
+    vertices.append({bottomLeft, color});
+    vertices.append({bottomLeft, color});
+    vertices.append({topRight, color});
+    vertices.append({bottomRight, color});
+}
+
+} // namespace
+
 Visualizer::Visualizer(
     std::pair<unsigned int, unsigned int> worldSize,
     std::pair<unsigned int, unsigned int> screenSize
 )
     : worldSize(worldSize),
-      window(sf::VideoMode({screenSize.first, screenSize.second}), "Ants") {
-    window.setFramerateLimit(144);
+      window(std::in_place, sf::VideoMode({screenSize.first, screenSize.second}), "Ants"),
+      target(&*window),
+      trailOverlay(worldSize.first, worldSize.second, PheromoneType::FoodTrail, trailColorMap),
+      font("resources/Arial Unicode.ttf"),
+      statsText(font),
+      replayStatusText(font),
+      profileText(font) {
+    window->setFramerateLimit(144);
+    setUpTexts();
+}
+
+Visualizer::Visualizer(
+    std::pair<unsigned int, unsigned int> worldSize,
+    std::pair<unsigned int, unsigned int> screenSize,
+    Offscreen
+)
+    : worldSize(worldSize),
+      offscreen(std::in_place, sf::Vector2u(screenSize.first, screenSize.second)),
+      target(&*offscreen),
+      trailOverlay(worldSize.first, worldSize.second, PheromoneType::FoodTrail, trailColorMap),
+      font("resources/Arial Unicode.ttf"),
+      statsText(font),
+      replayStatusText(font),
+      profileText(font) {
+    setUpTexts();
+}
+
+void Visualizer::setUpTexts() {
+    for (sf::Text* text : {&statsText, &replayStatusText, &profileText}) {
+        text->setCharacterSize(12);
+        text->setFillColor(sf::Color::White);
+    }
+    replayStatusText.setPosition({0.0f, 14.0f});
 }
 
 float Visualizer::getWorldToScreenMultiplier() {
-    return (static_cast<float>(window.getSize().y - (marginWidth * 2)) / worldSize.second);
+    return (static_cast<float>(target->getSize().y - (marginWidth * 2)) / worldSize.second);
 }
 
 float Visualizer::scaleToScreen(float worldValue) {
@@ -34,16 +113,48 @@ float Visualizer::toWorldCoordinate(float screenCoordinate) {
 }
 
 void Visualizer::processEvents() {
-    while (const std::optional event = window.pollEvent()) {
-        if (event->is<sf::Event::Closed>())
-            window.close();
+    if (!window) return;
+    while (const std::optional event = window->pollEvent()) {
+        if (event->is<sf::Event::Closed>()) {
+            window->close();
+        } else if (const auto* key = event->getIf<sf::Event::KeyPressed>()) {
+            if (keyHandler) keyHandler(key->code);
+        } else if (const auto* press = event->getIf<sf::Event::MouseButtonPressed>()) {
+            if (scrubHandler && press->button == sf::Mouse::Button::Left &&
+                getProgressBarBounds().contains(sf::Vector2f(press->position))) {
+                scrubbing = true;
+                scrubTo(press->position);
+            }
+        } else if (const auto* move = event->getIf<sf::Event::MouseMoved>()) {
+            if (scrubbing) scrubTo(move->position);
+        } else if (event->is<sf::Event::MouseButtonReleased>()) {
+            scrubbing = false;
+        }
     }
 }
 
+void Visualizer::setKeyHandler(std::function<void(sf::Keyboard::Key)> handler) {
+    keyHandler = std::move(handler);
+}
+
+void Visualizer::setScrubHandler(std::function<void(float)> handler) {
+    scrubHandler = std::move(handler);
+}
+
+sf::FloatRect Visualizer::getProgressBarBounds() const {
+    const sf::Vector2f windowSize(target->getSize());
+    return sf::FloatRect({marginWidth, windowSize.y - marginWidth + 5.0f},
+                         {windowSize.x - 2.0f * marginWidth, marginWidth - 10.0f});
+}
+
+void Visualizer::scrubTo(sf::Vector2i mousePosition) {
+    const sf::FloatRect bar = getProgressBarBounds();
+    const float fraction = (static_cast<float>(mousePosition.x) - bar.position.x) / bar.size.x;
+    scrubHandler(std::clamp(fraction, 0.0f, 1.0f));
+}
+
 void Visualizer::clear() {
-    window.clear(backgroundColor);
-    antShapes.clear();
-    foodShapes.clear();
+    target->clear(backgroundColor);
 }
 
 void Visualizer::drawNest(World& world) {
@@ -52,117 +163,212 @@ void Visualizer::drawNest(World& world) {
     nestShape.setSize(sf::Vector2f());
     nestShape.setPosition({toScreenCoordinate(position.getX()), toScreenCoordinate(position.getY())});
     nestShape.setFillColor(nestColor);
-    window.draw(nestShape);
+    target->draw(nestShape);
 }
 
-void Visualizer::drawTile(const Tile* tile) {
-    if (!tile) return;
-    const auto tileWorldPosition = tile->getPosition();
-    float screenX = toScreenCoordinate(tileWorldPosition.getX());
-    float screenY = toScreenCoordinate(tileWorldPosition.getY());
+void Visualizer::updateTerrainLayer(World& world) {
     const float tileSize = scaleToScreen(1);
-    
-    // Create a rectangle shape for the tile
-    sf::RectangleShape tileShape(sf::Vector2f(tileSize, tileSize));
-    tileShape.setPosition({screenX, screenY});
-    
-    switch (tile->getTerrain()) {
-    case TerrainType::GRASS:
-        tileShape.setFillColor(sf::Color(34, 139, 34));  // Forest Green
-        break;
-    case TerrainType::ROCK:
-        tileShape.setFillColor(sf::Color(128, 128, 128));  // Gray
-        break;
-    case TerrainType::SAND:
-        tileShape.setFillColor(sf::Color(238, 214, 175));  // Sandy Brown
-        break;
-    case TerrainType::SOIL:
-        tileShape.setFillColor(sf::Color(200, 200, 150));  // Soil brown
-        break;
-    default:
-        tileShape.setFillColor(sf::Color(169, 169, 169));  // Dark Gray (default)
-        break;
-    }
-    
-    tileShape.setOutlineThickness(1.0f);
-    tileShape.setOutlineColor(sf::Color(0, 0, 0, 40));  // Semi-transparent black
-    window.draw(tileShape);
-}
+    const sf::Vector2u layerSize(static_cast<unsigned int>(std::ceil(tileSize * worldSize.first)),
+                                 static_cast<unsigned int>(std::ceil(tileSize * worldSize.second)));
+    if (terrainLayerWorld == &world && terrainLayerRevision == world.getTerrainRevision() &&
+        terrainLayer.getSize() == layerSize) {
+        return;
+    }
+    if (terrainLayer.getSize() != layerSize && !terrainLayer.resize(layerSize)) {
+        return;
+    }
+    terrainLayerWorld = &world;
+    terrainLayerRevision = world.getTerrainRevision();
 
-void Visualizer::drawTerrain(World& world) {
-    world.forEachTile([this](Tile* tile) {
-        drawTile(tile);
-
-        const float foodTrail = tile->getPheromone(PheromoneType::FoodTrail);
-        if (foodTrail > 0.0f) {
-            const auto pos = tile->getPosition();
-            const float tileSize = scaleToScreen(1);
-            sf::RectangleShape overlay(sf::Vector2f(tileSize, tileSize));
-            overlay.setPosition({toScreenCoordinate(pos.getX()), toScreenCoordinate(pos.getY())});
-            const int alpha = std::min(200, static_cast<int>(foodTrail * 6.0f));
-            overlay.setFillColor(sf::Color(80, 180, 255, alpha));
-            window.draw(overlay);
+    // One pixel per tile, scaled up with nearest filtering. Worlds larger
+    // than the biggest texture are sampled every `stride` tiles.
+    const unsigned int stride = 1 + (std::max(worldSize.first, worldSize.second) - 1) / sf::Texture::getMaximumSize();
+    const sf::Vector2u imageSize((worldSize.first + stride - 1) / stride, (worldSize.second + stride - 1) / stride);
+    sf::Image image(imageSize, defaultTerrainColor);
+    for (unsigned int y = 0; y < imageSize.y; ++y) {
+        for (unsigned int x = 0; x < imageSize.x; ++x) {
+            const Tile* tile = world.getTile(static_cast<int>(x * stride), static_cast<int>(y * stride));
+            image.setPixel({x, y}, colorForTerrain(tile->getTerrain()));
         }
+    }
+    const sf::Texture texture(image);
+    sf::Sprite terrain(texture);
+    terrain.setScale({tileSize * stride, tileSize * stride});
 
-        if (tile->getHasFood()) {
-            drawFood(tile->getPosition(), tile->getFoodAmount());
+    terrainLayer.clear(sf::Color::Transparent);
+    terrainLayer.draw(terrain);
+    // Tile outlines only where they are still distinguishable from noise.
+    if (tileSize >= 4.0f && stride == 1) {
+        const sf::Vector2f extent(layerSize);
+        sf::VertexArray grid(sf::PrimitiveType::Lines);
+        const sf::Color gridColor(0, 0, 0, 40); // Semi-transparent black
+        for (unsigned int x = 0; x <= worldSize.first; ++x) {
+            grid.append({{x * tileSize, 0.0f}, gridColor});
+            grid.append({{x * tileSize, extent.y}, gridColor});
+        }
+        for (unsigned int y = 0; y <= worldSize.second; ++y) {
+            grid.append({{0.0f, y * tileSize}, gridColor});
+            grid.append({{extent.x, y * tileSize}, gridColor});
         }
-    });
+        terrainLayer.draw(grid);
+    }
+    terrainLayer.display();
+}
+
+void Visualizer::drawTerrain(World& world) {
+    ScopedPhaseTimer timer(ProfilePhase::RenderTerrain);
+    updateTerrainLayer(world);
+    sf::Sprite terrain(terrainLayer.getTexture());
+    terrain.setPosition({marginWidth, marginWidth});
+    target->draw(terrain);
 }
 
-void Visualizer::drawAnt(Ant& ant, float interpolation) {
-    sf::RectangleShape antShape;
-    antShape.setSize(sf::Vector2f(scaleToScreen(ant.getSize()), scaleToScreen(ant.getSize())));
-    FloatPosition currentPos = ant.getPosition();
-    FloatPosition prevPos = ant.getPreviousPosition();
-    
-    // Interpolate between previous and current position
-    float x = prevPos.getX() + (currentPos.getX() - prevPos.getX()) * interpolation;
-    float y = prevPos.getY() + (currentPos.getY() - prevPos.getY()) * interpolation;
-    antShape.setPosition({toScreenCoordinate(x), toScreenCoordinate(y)});
-    antShape.setFillColor(ant.getColor());
-    window.draw(antShape);
+void Visualizer::drawFood(const RenderSnapshot& snapshot) {
+    ScopedPhaseTimer timer(ProfilePhase::RenderFood);
+    const float tileSize = scaleToScreen(1);
+    const float foodSize = tileSize / 2;
+    foodVertices.clear();
+    for (const RenderSnapshot::Food& food : snapshot.food) {
+        const sf::Vector2f screenPos(marginWidth + food.x * tileSize + foodSize / 2,
+                                     marginWidth + food.y * tileSize + foodSize / 2);
+        // Brighter green for more food
+        const int intensity = std::min(255, static_cast<int>(100 + food.amount * 155 / 100));
+        appendQuad(foodVertices, screenPos, {foodSize, foodSize}, sf::Color(0, static_cast<std::uint8_t>(intensity), 0));
+    }
+    target->draw(foodVertices);
 }
 
-void Visualizer::drawFood(const IntegerPosition& pos, float amount) {
-    sf::RectangleShape foodShape;
+void Visualizer::drawTrailOverlay(const RenderSnapshot& snapshot) {
+    ScopedPhaseTimer timer(ProfilePhase::RenderOverlay);
+    if (!trailTextureReady) {
+        // A world too large for one texture is drawn without the overlay.
+        if (!trailTexture.resize({worldSize.first, worldSize.second})) return;
+        trailTextureReady = true;
+        trailTexture.update(trailOverlay.getPixels());
+    }
+    if (trailOverlay.update(snapshot.trailBlocks, snapshot.trailValues.data(), snapshot.trailRevision)) {
+        const unsigned int begin = trailOverlay.getDirtyRowBegin();
+        const unsigned int rows = trailOverlay.getDirtyRowEnd() - begin;
+        trailTexture.update(trailOverlay.getPixels() + static_cast<std::size_t>(begin) * worldSize.first * 4,
+                            {worldSize.first, rows}, {0, begin});
+    }
     const float tileSize = scaleToScreen(1);
-    const float width = tileSize / 2;
-    foodShape.setSize(sf::Vector2f(width, width));
-    foodShape.setPosition({toScreenCoordinate(pos.getX()) + width/2, toScreenCoordinate(pos.getY()) + width/2});
-    
-    // Brighter green for more food
-    int intensity = std::min(255, static_cast<int>(100 + amount * 155 / 100));
-    foodShape.setFillColor(sf::Color(0, intensity, 0));
-    
-    foodShapes.push_back(foodShape);
-    window.draw(foodShape);
-}
-
-void Visualizer::drawWorld(World& world, float interpolation) {
+    sf::Sprite trail(trailTexture);
+    trail.setPosition({marginWidth, marginWidth});
+    trail.setScale({tileSize, tileSize});
+    target->draw(trail);
+}
+
+void Visualizer::appendAntAt(float x, float y, AntRole role) {
+    const float size = scaleToScreen(configForRole(role).size);
+    appendQuad(antVertices, {toScreenCoordinate(x), toScreenCoordinate(y)}, {size, size}, colorForRole(role));
+}
+
+void Visualizer::drawSnapshot(World& world, const RenderSnapshot& snapshot, float interpolation) {
     drawTerrain(world);
-    for (const auto& ant : world.getAnts()) {
-        drawAnt(*ant, interpolation);
+    drawTrailOverlay(snapshot);
+    drawFood(snapshot);
+    ScopedPhaseTimer timer(ProfilePhase::RenderAnts);
+    antVertices.clear();
+    for (std::size_t i = 0; i < snapshot.positions.size(); ++i) {
+        // Interpolate between previous and current position
+        const FloatPosition& currentPos = snapshot.positions[i];
+        const FloatPosition& prevPos = snapshot.previousPositions[i];
+        const float x = prevPos.getX() + (currentPos.getX() - prevPos.getX()) * interpolation;
+        const float y = prevPos.getY() + (currentPos.getY() - prevPos.getY()) * interpolation;
+        appendAntAt(x, y, snapshot.roles[i]);
     }
+    target->draw(antVertices);
+}
+
+void Visualizer::drawReplay(World& world, const RenderSnapshot& scene, const TrajectoryPlayer::FramePair& frames) {
+    drawTerrain(world);
+    drawTrailOverlay(scene);
+    drawFood(scene);
+    if (!frames.previous) return;
+
+    ScopedPhaseTimer timer(ProfilePhase::RenderAnts);
+    // Frames from different blocks can hold different ants; only
+    // interpolate when both describe the same ants in the same order.
+    const auto& previous = frames.previous->ants;
+    const bool interpolate = frames.next && frames.next->ants.size() == previous.size();
+    antVertices.clear();
+    for (std::size_t i = 0; i < previous.size(); ++i) {
+        const trajectory::AntSample& from = previous[i];
+        float x = from.x;
+        float y = from.y;
+        if (interpolate && frames.next->ants[i].id == from.id) {
+            const trajectory::AntSample& to = frames.next->ants[i];
+            x += (to.x - from.x) * frames.interpolation;
+            y += (to.y - from.y) * frames.interpolation;
+        }
+        appendAntAt(x, y, from.role);
+    }
+    target->draw(antVertices);
 }
 
 void Visualizer::display() {
-    window.display();
+    ScopedPhaseTimer timer(ProfilePhase::Present);
+    if (window) {
+        window->display();
+    } else {
+        offscreen->display();
+    }
+}
+
+void Visualizer::displayStats(float fps, int simStepsLastFrame, float droppedSeconds) {
+    std::string statsStr = "FPS: " + std::to_string(static_cast<int>(fps)) +
+                           " | Sim Steps: " + std::to_string(simStepsLastFrame);
+    if (droppedSeconds > 0.0f) {
+        char dropped[48];
+        std::snprintf(dropped, sizeof(dropped), " | Dropped: %.1f s", droppedSeconds);
+        statsStr += dropped;
+    }
+    statsText.setString(statsStr);
+    target->draw(statsText);
+}
+
+void Visualizer::displayReplayStatus(const TrajectoryPlayer& player) {
+    const sf::FloatRect bar = getProgressBarBounds();
+    const double span = std::max<double>(1.0, static_cast<double>(player.getEndTick() - player.getFirstTick()) - 1.0);
+    const float fraction = static_cast<float>((player.getPosition() - player.getFirstTick()) / span);
+
+    sf::RectangleShape track(bar.size);
+    track.setPosition(bar.position);
+    track.setFillColor(sf::Color(60, 60, 60));
+    target->draw(track);
+    sf::RectangleShape progress({bar.size.x * std::clamp(fraction, 0.0f, 1.0f), bar.size.y});
+    progress.setPosition(bar.position);
+    progress.setFillColor(sf::Color(80, 180, 255));
+    target->draw(progress);
+
+    replayStatusText.setString("Tick " + std::to_string(static_cast<std::uint64_t>(player.getPosition())) + " / " +
+                               std::to_string(player.getEndTick() - 1) + " | " +
+                               std::to_string(static_cast<int>(player.getSpeed())) + " ticks/s | " +
+                               (player.isPlaying() ? "playing" : "paused"));
+    target->draw(replayStatusText);
 }
 
-void Visualizer::displayStats(float fps, int simStepsLastFrame) {
-    sf::Font font("resources/Arial Unicode.ttf");
-    sf::Text fpsText(font);
-    fpsText.setCharacterSize(12);
-    fpsText.setFillColor(sf::Color::White);
-    
-    std::string statsStr = "FPS: " + std::to_string(static_cast<int>(fps)) + 
-                          " | Sim Steps: " + std::to_string(simStepsLastFrame);
-    fpsText.setString(statsStr);
-    
-    window.draw(fpsText);
+void Visualizer::displayProfile() {
+    if (!profiler::isEnabled()) return;
+    if (rollingProfile.refresh()) {
+        std::string lines = "phase p50 / p99 (us, last second)";
+        char line[96];
+        for (std::size_t p = 0; p < kProfilePhaseCount; ++p) {
+            const auto phase = static_cast<ProfilePhase>(p);
+            const RollingProfile::PhaseStats& stats = rollingProfile.get(phase);
+            if (stats.count == 0) continue;
+            std::snprintf(line, sizeof(line), "\n%s: %.1f / %.1f", profilePhaseName(phase),
+                          stats.p50 / 1e3, stats.p99 / 1e3);
+            lines += line;
+        }
+        profileText.setString(lines);
+        const sf::FloatRect bounds = profileText.getLocalBounds();
+        profileText.setPosition({static_cast<float>(target->getSize().x) - bounds.size.x - marginWidth, 0.0f});
+    }
+    target->draw(profileText);
 }
 
 bool Visualizer::isOpen() const {
-    return window.isOpen();
+    return !window || window->isOpen();
 }
\ No newline at end of file
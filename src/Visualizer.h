@@ -1,9 +1,16 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <optional>
 #include <vector>
 #include <SFML/Graphics.hpp>
 #include "Ant.h"
+#include "PheromoneOverlay.h"
+#include "Profiler.h"
+#include "RenderSnapshot.h"
 #include "Tile.h"
+#include "TrajectoryPlayer.h"
 
 class World;
 class Vector2D;
@@ -14,40 +21,97 @@ const sf::Color nestColor = sf::Color(139, 69, 19);
 
 class Visualizer {
 private:
-    sf::RenderWindow window;
+    // Exactly one of these exists; everything is drawn through target.
+    std::optional<sf::RenderWindow> window;
+    std::optional<sf::RenderTexture> offscreen;
+    sf::RenderTarget* target;
     std::pair<unsigned int, unsigned int> worldSize;
-    std::vector<sf::RectangleShape> antShapes;
     sf::RectangleShape nestShape;
-    std::vector<sf::RectangleShape> foodShapes;
+    // Terrain rendered at screen resolution, redrawn only when the world's
+    // terrain revision (or the world) changes.
+    sf::RenderTexture terrainLayer;
+    const World* terrainLayerWorld = nullptr;
+    std::uint64_t terrainLayerRevision = 0;
+    // Food trail as one texture, one pixel per tile; only rows the overlay
+    // repainted are uploaded.
+    PheromoneOverlay trailOverlay;
+    sf::Texture trailTexture;
+    bool trailTextureReady = false;
+    // Refilled every frame; each is drawn with a single draw call.
+    sf::VertexArray foodVertices{sf::PrimitiveType::Triangles};
+    sf::VertexArray antVertices{sf::PrimitiveType::Triangles};
+    // Loaded once; the text objects only change their strings.
+    sf::Font font;
+    sf::Text statsText;
+    sf::Text replayStatusText;
+    sf::Text profileText;
+    RollingProfile rollingProfile;
     float marginWidth = 20.0f; 
+    std::function<void(sf::Keyboard::Key)> keyHandler;
+    std::function<void(float)> scrubHandler;
+    bool scrubbing = false;
     float getWorldToScreenMultiplier();
     float scaleToScreen(float worldValue);
     float scaleToWorld(float screenValue);
     float toScreenCoordinate(float worldValue);
     float toWorldCoordinate(float screenValue);
 
+    void setUpTexts();
+
     void drawNest(World& world);
     
     void drawTerrain(World& world);
 
-    void drawTile(const Tile* tile);
-    
-    void drawAnt(Ant& ant, float interpolation);
-    
-    void drawFood(const IntegerPosition& pos, float amount);
+    void updateTerrainLayer(World& world);
+
+    void drawTrailOverlay(const RenderSnapshot& snapshot);
+
+    void drawFood(const RenderSnapshot& snapshot);
+
+    void appendAntAt(float x, float y, AntRole role);
+
+    sf::FloatRect getProgressBarBounds() const;
+
+    void scrubTo(sf::Vector2i mousePosition);
 
 public:
+    // Selects the constructor that renders into a texture instead of a
+    // window, e.g. for benchmarks.
+    struct Offscreen {};
+
     Visualizer(std::pair<unsigned int, unsigned int> worldSize, std::pair<unsigned int, unsigned int> screenSize);
+    Visualizer(std::pair<unsigned int, unsigned int> worldSize, std::pair<unsigned int, unsigned int> screenSize,
+               Offscreen);
 
     void processEvents();
 
+    // Called for every key press during processEvents().
+    void setKeyHandler(std::function<void(sf::Keyboard::Key)> handler);
+
+    // Called with the clicked/dragged fraction (0..1) of the replay progress bar.
+    void setScrubHandler(std::function<void(float)> handler);
+
     void clear();
 
-    void drawWorld(World& world, float interpolation);
+    // Terrain from `world` (which may be ticking on another thread), the
+    // rest from the snapshot, with ants `interpolation` of the way from their
+    // previous to their current positions.
+    void drawSnapshot(World& world, const RenderSnapshot& snapshot, float interpolation);
+
+    // Terrain, food and trail as in drawSnapshot(), ants from a recorded
+    // frame pair instead.
+    void drawReplay(World& world, const RenderSnapshot& scene, const TrajectoryPlayer::FramePair& frames);
     
     void display();
 
-    void displayStats(float fps, int simStepsLastFrame);
+    // droppedSeconds: simulated time skipped because ticks fell behind.
+    void displayStats(float fps, int simStepsLastFrame, float droppedSeconds = 0.0f);
+
+    void displayReplayStatus(const TrajectoryPlayer& player);
+
+    // Rolling p50/p99 of every profiled phase, while the profiler is enabled.
+    void displayProfile();
     
+    // Always true when rendering offscreen.
     bool isOpen() const;
 };
\ No newline at end of file
@@ -1,36 +1,41 @@
+#include <algorithm>
+#include <cstdint>
 #include <random>
+#include <span>
+#include "MovementKernels.h"
+#include "Profiler.h"
+#include "Random.h"
 #include "Tile.h"
 #include "World.h"
 
 
 World::World(unsigned int width, unsigned int height, const unsigned int initial_colony_size,
-             std::optional<unsigned int> seed)
-    :
-    pheromoneScratch(static_cast<std::size_t>(width) * height),
-    rng(seed.value_or(std::random_device{}())),
-    width(width),
-    height(height) {
-    tiles.reserve(static_cast<std::size_t>(width) * height);
-    for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            tiles.emplace_back(IntegerPosition(x, y), TerrainType::SOIL);
-        }
-    }
+             std::optional<unsigned int> seed,
+             const std::optional<std::filesystem::path>& chunkBackingFile)
+    : World(width, height, seed.value_or(std::random_device{}()), initial_colony_size, chunkBackingFile,
+            Uninitialized{}) {
     initialize(initial_colony_size);
 }
 
-std::shared_ptr<Ant> World::createAnt(AntRole role, const IntegerPosition& pos) {
-    auto ant = std::make_shared<Ant>(role, idGenerator.getNextId(), rng);
-    addAnt(ant, pos);
-    return ant;
+World::World(unsigned int width, unsigned int height, unsigned int seed, std::size_t expectedAntCount,
+             const std::optional<std::filesystem::path>& chunkBackingFile, Uninitialized)
+    :
+    seed(seed),
+    tiles(width, height, [this](Tile& tile) { generateTile(tile); }, chunkBackingFile),
+    pheromones(width, height),
+    trailGradient(width, height),
+    nestFlow(width, height),
+    occupancy(width, height, OccupancyGrid::chooseCellShift(width, height, expectedAntCount)),
+    rng(this->seed),
+    width(width),
+    height(height) {
 }
 
 void World::initialize(const unsigned int initial_colony_size) {
-    generateTerrain();
-
     placeNest(IntegerPosition(width / 2, height / 2));
     const IntegerPosition nestPosition = getNestEntrancePosition();
-    createAnt(AntRole::QUEEN, nestPosition);
+    ants.reserve(ants.size() + initial_colony_size);
+    addAnt(AntRole::QUEEN, nestPosition);
 
     std::uniform_int_distribution<int> roleRoll(1, 100);
     for (int i = 1; i < initial_colony_size; ++i) {
@@ -47,9 +52,10 @@ void World::initialize(const unsigned int initial_colony_size) {
         } else {
             role = AntRole::DRONE;
         }
-        createAnt(role, nestPosition);
+        addAnt(role, nestPosition);
     }
-    spawnFood(width * height / 20);
+    ants.groupByRole();
+    occupancy.rebuild(ants.positions);
 }
 
 IntegerPosition World::getNestEntrancePosition() const {
@@ -59,11 +65,14 @@ IntegerPosition World::getNestEntrancePosition() const {
 void World::placeNest(const IntegerPosition& pos) {
     if (isValidPosition(pos)) {
         nestEntrancePosition = std::make_unique<IntegerPosition>(pos);
-        getTile(pos)->setNestEntrance(true);
+        Tile* nest = getTile(pos);
+        nest->setNestEntrance(true);
+        nest->removeFood(nest->getFoodAmount());
+        ++foodRevision;
         
         // Make adjacent tiles soil for easier access
         for (auto& adjPos : getAdjacentPositions(pos)) {
-            getTile(adjPos)->setTerrain(TerrainType::SOIL);
+            setTerrain(adjPos, TerrainType::SOIL);
         }
     }
 }
@@ -76,18 +85,64 @@ int World::getHeight() const {
     return height;
 }
 
-void World::generateTerrain() {
-    std::uniform_int_distribution<> distr(0, 100);
-    std::uniform_int_distribution<> terrainType(0, 4);
+unsigned int World::getSeed() const {
+    return seed;
+}
 
-    for (int x = 0; x < width; x++) {
-        for (int y = 0; y < height; y++) {
-            // 10% chance of special terrain
-            if (distr(rng) < 10) {
-                TerrainType terrain = static_cast<TerrainType>(terrainType(rng));
-                getTile(x, y)->setTerrain(terrain);
-            }
-        }
+void World::setThreadCount(unsigned int threadCount) {
+    if (threadCount <= 1) {
+        threadPool.reset();
+    } else if (!threadPool || threadPool->getThreadCount() != threadCount) {
+        threadPool = std::make_unique<ThreadPool>(threadCount);
+    }
+}
+
+unsigned int World::getThreadCount() const {
+    return threadPool ? threadPool->getThreadCount() : 1;
+}
+
+std::uint64_t World::getTick() const {
+    return tick;
+}
+
+std::uint64_t World::getTerrainRevision() const {
+    return terrainRevision;
+}
+
+std::uint64_t World::getFoodRevision() const {
+    return foodRevision;
+}
+
+std::size_t World::getLoadedChunkCount() const {
+    return tiles.getLoadedChunkCount();
+}
+
+std::uint64_t World::tileBits(unsigned int x, unsigned int y) const {
+    // One hash per tile, so a chunk comes out the same whenever and on
+    // whichever thread it is first loaded.
+    const std::uint64_t key = (static_cast<std::uint64_t>(y) << 32) | x;
+    return CounterRng::splitMix64(seed ^ CounterRng::splitMix64(key));
+}
+
+namespace {
+
+TerrainType generatedTerrain(std::uint32_t terrainBits) {
+    // 10% chance of special terrain
+    return terrainBits % 100 < 10 ? static_cast<TerrainType>((terrainBits >> 8) % 4) : TerrainType::SOIL;
+}
+
+} // namespace
+
+void World::generateTile(Tile& tile) const {
+    const IntegerPosition pos = tile.getPosition();
+    const std::uint64_t bits = tileBits(pos.getIntX(), pos.getIntY());
+    const auto terrainBits = static_cast<std::uint32_t>(bits);
+    const auto foodBits = static_cast<std::uint32_t>(bits >> 32);
+
+    tile.setTerrain(generatedTerrain(terrainBits));
+    // One tile in 20 starts with 1-100 food
+    if (foodBits % 20 == 0) {
+        tile.addFood(static_cast<float>(1 + (foodBits >> 8) % 100));
     }
 }
 
@@ -97,23 +152,38 @@ float World::distanceToNest(const FloatPosition& pos) const {
 
 Tile* World::getTile(int x, int y) {
     if (!isValidPosition(x, y)) return nullptr;
-    return &tiles[tileIndex(x, y)];
+    return &tiles.at(x, y);
 }
 
 Tile* World::getTile(const IntegerPosition& pos) {
-    return getTile(static_cast<int>(pos.getX()), static_cast<int>(pos.getY()));
+    if (!isValidPosition(pos)) return nullptr;
+    return &tiles.at(pos.getIntX(), pos.getIntY());
 }
 
 Tile* World::getTile(const FloatPosition& pos) {
     return getTile(pos.toIntegerPosition());
 }
 
-const std::vector<std::shared_ptr<Ant>>& World::getAnts() const {
+AntStore& World::getAnts() {
+    return ants;
+}
+
+const AntStore& World::getAnts() const {
     return ants;
 }
 
+const OccupancyGrid& World::getOccupancy() const {
+    return occupancy;
+}
+
+std::size_t World::getAntCountAt(const IntegerPosition& pos) const {
+    if (!isValidPosition(pos)) return 0;
+    return occupancy.countInTile(pos.getIntX(), pos.getIntY(), ants.positions);
+}
+
 bool World::isValidPosition(const IntegerPosition& pos) const {
-    return pos.getX() >= 0 && pos.getX() < width && pos.getY() >= 0 && pos.getY() < height;
+    // Coordinates that went below zero wrapped around and fail the same test.
+    return pos.getIntX() < width && pos.getIntY() < height;
 }
 
 bool World::isValidPosition(const FloatPosition& pos) const {
@@ -121,19 +191,20 @@ bool World::isValidPosition(const FloatPosition& pos) const {
 }
 
 bool World::isValidPosition(int x, int y) const {
-    return isValidPosition(IntegerPosition(x, y));
+    return x >= 0 && y >= 0 && static_cast<unsigned int>(x) < width && static_cast<unsigned int>(y) < height;
 }
 
 std::vector<IntegerPosition> World::getAdjacentPositions(const IntegerPosition& pos) {
-    std::vector<IntegerPosition> adjacentPositions;
-    
     // 4-way adjacency (North, East, South, West)
-    const std::vector<std::pair<int, int>> directions = {
+    static constexpr std::array<std::pair<int, int>, 4> directions{{
         {0, -1}, {1, 0}, {0, 1}, {-1, 0}
-    };
-    
+    }};
+
+    std::vector<IntegerPosition> adjacentPositions;
+    adjacentPositions.reserve(directions.size());
     for (const auto& dir : directions) {
-        IntegerPosition newPosition(pos.getX() + dir.first, pos.getY() + dir.second);
+        // Unsigned wrap-around puts steps off the left or top edge out of range.
+        IntegerPosition newPosition(pos.getIntX() + dir.first, pos.getIntY() + dir.second);
         if (isValidPosition(newPosition)) {
             adjacentPositions.push_back(newPosition);
         }
@@ -144,62 +215,176 @@ std::vector<IntegerPosition> World::getAdjacentPositions(const IntegerPosition&
 
 void World::depositPheromone(const IntegerPosition& pos, PheromoneType type, float amount) {
     if (isValidPosition(pos)) {
-        getTile(pos)->depositPheromone(type, amount);
+        pheromones.deposit(pos.getIntX(), pos.getIntY(), type, amount);
     }
 }
 
+float World::getPheromone(const IntegerPosition& pos, PheromoneType type) const {
+    return getPheromone(static_cast<int>(pos.getIntX()), static_cast<int>(pos.getIntY()), type);
+}
+
+float World::getPheromone(int x, int y, PheromoneType type) const {
+    if (!isValidPosition(x, y)) return 0.0f;
+    return pheromones.get(x, y, type);
+}
+
+Vector2D World::getTrailGradient(const IntegerPosition& pos) const {
+    if (!isValidPosition(pos)) return Vector2D();
+    // Outside a tick (or before the first one) the field may be stale.
+    if (trailGradient.isCurrent(pheromones)) {
+        return trailGradient.get(pos.getIntX(), pos.getIntY());
+    }
+    return GradientField::compute(pheromones, PheromoneType::FoodTrail, pos.getIntX(), pos.getIntY());
+}
+
+Vector2D World::getNestFlow(const IntegerPosition& pos) const {
+    return nestFlow.get(pos.getIntX(), pos.getIntY());
+}
+
+const PheromoneField& World::getPheromones() const {
+    return pheromones;
+}
+
 void World::updatePheromones() {
     // Double-buffered diffusion + decay. For each tile, the next value is a
     // blend of the tile's current value and the average of its 4-neighbours,
     // then multiplied by a decay factor. Values below a floor snap to zero so
-    // faint trails don't linger indefinitely. The scratch buffer lives on the
-    // World so no per-tick allocation happens.
-    static constexpr float kSelfWeight = 0.80f;
-    static constexpr float kNeighborWeight = 1.0f - kSelfWeight;
-    static constexpr float kDecay = 0.95f;
-    static constexpr float kFloor = 0.05f;
-
-    const int w = static_cast<int>(width);
-    const int h = static_cast<int>(height);
-
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            const std::size_t idx = tileIndex(x, y);
-            for (std::size_t t = 0; t < kPheromoneTypeCount; ++t) {
-                const auto type = static_cast<PheromoneType>(t);
-                const float self = tiles[idx].getPheromone(type);
-
-                float neighborSum = 0.0f;
-                int neighborCount = 0;
-                if (x > 0)     { neighborSum += tiles[tileIndex(x - 1, y)].getPheromone(type); ++neighborCount; }
-                if (x < w - 1) { neighborSum += tiles[tileIndex(x + 1, y)].getPheromone(type); ++neighborCount; }
-                if (y > 0)     { neighborSum += tiles[tileIndex(x, y - 1)].getPheromone(type); ++neighborCount; }
-                if (y < h - 1) { neighborSum += tiles[tileIndex(x, y + 1)].getPheromone(type); ++neighborCount; }
-                const float neighborAvg = neighborCount > 0 ? neighborSum / neighborCount : 0.0f;
-
-                float blended = (self * kSelfWeight + neighborAvg * kNeighborWeight) * kDecay;
-                if (blended < kFloor) blended = 0.0f;
-                pheromoneScratch[idx][t] = blended;
+    // faint trails don't linger indefinitely. Indexed by PheromoneType.
+    static constexpr PheromoneField::ChannelParams kDiffusion{{
+        // FoodTrail
+        { .selfWeight = 0.80f, .neighborWeight = 0.20f, .decay = 0.95f, .floor = 0.05f },
+        // HomeTrail: stays sharp and lasts, so the way back survives long trips
+        { .selfWeight = 0.90f, .neighborWeight = 0.10f, .decay = 0.98f, .floor = 0.05f },
+        // Alarm: spreads fast and is gone within a few ticks
+        { .selfWeight = 0.50f, .neighborWeight = 0.50f, .decay = 0.80f, .floor = 0.10f },
+        // Recruitment: between the two
+        { .selfWeight = 0.70f, .neighborWeight = 0.30f, .decay = 0.90f, .floor = 0.05f },
+    }};
+    ScopedPhaseTimer timer(ProfilePhase::PheromoneDiffusion);
+    pheromones.diffuse(kDiffusion, threadPool.get());
+}
+
+void World::updateAntRange(std::size_t begin, std::size_t end) {
+    // Ants go through the tick in batches of one role, one stage at a time.
+    // Wander roles only need their last direction and a random draw, so they
+    // are decided by the SIMD kernel; the rest (queen, forager) sense and
+    // branch per ant, taking their random direction from a batch prefilled by
+    // the same kernel.
+    static constexpr std::size_t kBatchSize = 64;
+
+    for (std::size_t r = 0; r < kAntRoleCount; ++r) {
+        const auto role = static_cast<AntRole>(r);
+        const auto [roleBegin, roleEnd] = ants.roleRange(role);
+        const std::size_t first = std::max(begin, roleBegin);
+        const std::size_t last = std::min(end, roleEnd);
+        if (first >= last) continue;
+
+        if (!movement_kernels::isWanderRole(role)) {
+            const FloatPosition nest(getNestEntrancePosition());
+            std::array<float, kBatchSize> nestDistances;
+            std::array<SensoryInput, kBatchSize> inputs;
+            std::array<MovementDecision, kBatchSize> decisions;
+            std::array<Vector2D, kBatchSize> randomDirections;
+            for (std::size_t batch = first; batch < last; batch += kBatchSize) {
+                const std::size_t count = std::min(kBatchSize, last - batch);
+                {
+                    ScopedPhaseTimer timer(ProfilePhase::Sensing);
+                    position_kernels::distances(std::span(&ants.positions[batch], count), nest, nestDistances);
+                    for (std::size_t i = 0; i < count; ++i) {
+                        inputs[i] = ants[batch + i].sense(*this, nestDistances[i]);
+                    }
+                }
+                {
+                    ScopedPhaseTimer timer(ProfilePhase::Decide);
+                    movement_kernels::peekUnitVectors(&ants.rngs[batch], count, randomDirections.data());
+                    for (std::size_t i = 0; i < count; ++i) {
+                        RandomDirections random(ants.rngs[batch + i], &randomDirections[i]);
+                        decisions[i] = decideMovement(role, inputs[i], random);
+                    }
+                }
+                {
+                    ScopedPhaseTimer timer(ProfilePhase::ApplyActions);
+                    for (std::size_t i = 0; i < count; ++i) {
+                        ants[batch + i].applyActions(decisions[i].actions);
+                    }
+                }
+                ScopedPhaseTimer timer(ProfilePhase::Move);
+                for (std::size_t i = 0; i < count; ++i) {
+                    ants[batch + i].advance(decisions[i].direction, *this);
+                }
             }
+            continue;
         }
-    }
 
-    for (std::size_t i = 0; i < tiles.size(); ++i) {
-        for (std::size_t t = 0; t < kPheromoneTypeCount; ++t) {
-            tiles[i].setPheromone(static_cast<PheromoneType>(t), pheromoneScratch[i][t]);
+        const float randomness = movement_kernels::wanderRandomnessFor(role);
+        std::array<Vector2D, kBatchSize> directions;
+        for (std::size_t batch = first; batch < last; batch += kBatchSize) {
+            const std::size_t count = std::min(kBatchSize, last - batch);
+            {
+                ScopedPhaseTimer timer(ProfilePhase::Decide);
+                movement_kernels::decideWander(&ants.lastDirections[batch], &ants.rngs[batch], count,
+                                               randomness, directions.data());
+            }
+            ScopedPhaseTimer timer(ProfilePhase::Move);
+            for (std::size_t i = 0; i < count; ++i) {
+                ants[batch + i].advance(directions[i], *this);
+            }
         }
     }
 }
 
 void World::updateAnts() {
-    for (auto& ant : ants) {
-        (*ant).update(*this);
+    // Ants only read shared world state during their update; everything they
+    // write lives in their own AntStore slot, so chunks of ants can run on
+    // any thread in any order.
+    static constexpr std::size_t kAntsPerChunk = 256;
+
+    if (!ants.isGroupedByRole()) {
+        ants.groupByRole();
+    }
+    {
+        // One pass over the active trail instead of four lookups and a
+        // square root per sensing ant.
+        ScopedPhaseTimer timer(ProfilePhase::Sensing);
+        trailGradient.update(pheromones, PheromoneType::FoodTrail, threadPool.get());
+        // Serial, and a no-op unless the nest moved or terrain changed.
+        nestFlow.update(getNestEntrancePosition(),
+                        [this](unsigned int x, unsigned int y) { return peekTerrain(x, y); });
+    }
+    if (threadPool) {
+        threadPool->parallelFor(ants.size(), kAntsPerChunk, [this](std::size_t begin, std::size_t end, unsigned int) {
+            updateAntRange(begin, end);
+        });
+    } else {
+        updateAntRange(0, ants.size());
+    }
+    {
+        ScopedPhaseTimer timer(ProfilePhase::ApplyActions);
+        applyPendingPheromones();
+    }
+    ScopedPhaseTimer timer(ProfilePhase::Move);
+    occupancy.rebuild(ants.positions);
+}
+
+void World::applyPendingPheromones() {
+    // Serial and in ant order, so the floating-point sums on shared tiles
+    // come out the same for every thread count.
+    for (std::size_t i = 0; i < ants.size(); ++i) {
+        auto& pending = ants.pendingPheromones[i];
+        for (std::size_t t = 0; t < kPheromoneTypeCount; ++t) {
+            if (pending[t] != 0.0f) {
+                depositPheromone(ants.previousPositions[i].toIntegerPosition(), static_cast<PheromoneType>(t), pending[t]);
+                pending[t] = 0.0f;
+            }
+        }
     }
 }
 
 void World::update() {
+    ScopedPhaseTimer timer(ProfilePhase::Tick);
     updateAnts();
     updatePheromones();
+    ++tick;
 }
 
 void World::placeFood(const IntegerPosition& pos, float amount) {
@@ -207,10 +392,27 @@ void World::placeFood(const IntegerPosition& pos, float amount) {
         Tile* tile = getTile(pos);
         if (!tile->getIsNestEntrance()) {
             tile->addFood(amount);
+            ++foodRevision;
         }
     }
 }
 
+void World::setTerrain(const IntegerPosition& pos, TerrainType terrain) {
+    Tile* tile = getTile(pos);
+    if (tile && tile->getTerrain() != terrain) {
+        tile->setTerrain(terrain);
+        ++terrainRevision;
+        nestFlow.markChanged(pos);
+    }
+}
+
+TerrainType World::peekTerrain(unsigned int x, unsigned int y) const {
+    if (const Tile* tile = tiles.find(x, y)) {
+        return tile->getTerrain();
+    }
+    return generatedTerrain(static_cast<std::uint32_t>(tileBits(x, y)));
+}
+
 void World::spawnFood(int count) {
     std::uniform_int_distribution<> posX(0, width - 1);
     std::uniform_int_distribution<> posY(0, height - 1);
@@ -233,16 +435,21 @@ void World::spawnFood(int count) {
     }
 }
 
-void World::addAnt(std::shared_ptr<Ant> ant, const IntegerPosition& pos) {
-    if (isValidPosition(pos)) {
-        ants.push_back(ant);
-        getTile(pos)->addAnt(ant);
-        (*ant).setPosition(FloatPosition(pos));
-    }
+std::optional<Ant> World::addAnt(AntRole role, const IntegerPosition& pos) {
+    if (!isValidPosition(pos)) return std::nullopt;
+    const int id = idGenerator.getNextId();
+    const std::size_t index = ants.add(id, role, FloatPosition(pos), CounterRng::forStream(seed, id));
+    return ants[index];
 }
 
 void World::forEachTile(std::function<void(Tile*)> callback) {
-    for (Tile& tile : tiles) {
-        callback(&tile);
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            callback(&tiles.at(x, y));
+        }
     }
+}
+
+void World::forEachLoadedTile(std::function<void(Tile*)> callback) {
+    tiles.forEachLoadedTile([&callback](Tile& tile) { callback(&tile); });
 }
\ No newline at end of file
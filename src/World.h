@@ -1,6 +1,8 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <filesystem>
 #include <optional>
 #include <random>
 #include <vector>
@@ -8,41 +10,77 @@
 #include <string>
 #include <functional>
 #include "Ant.h"
+#include "AntStore.h"
+#include "FlowField.h"
+#include "GradientField.h"
 #include "Id.h"
+#include "MovementStrategy.h"
+#include "OccupancyGrid.h"
 #include "Pheromone.h"
+#include "PheromoneField.h"
 #include "Position.h"
+#include "ThreadPool.h"
 #include "Tile.h"
+#include "TileStore.h"
 
 /**
  * @brief The main world class managing all tiles and coordinates
  */
 class World {
 private:
-    std::vector<Tile> tiles;
-    std::vector<std::array<float, kPheromoneTypeCount>> pheromoneScratch;
-    std::vector<std::shared_ptr<Ant>> ants;
+    friend class WorldSnapshot;
+    // Selects the constructor that leaves the world empty, for restoring.
+    struct Uninitialized {};
+
+    const unsigned int seed;
+    TileStore tiles;
+    PheromoneField pheromones;
+    // Food trail gradient as sensed by ants; refreshed at the start of each
+    // ant update when the trail changed.
+    GradientField trailGradient;
+    // Way home for ants heading back to the nest; built on the first tick and
+    // repaired around terrain edits.
+    FlowField nestFlow;
+    AntStore ants;
+    OccupancyGrid occupancy;
     std::unique_ptr<IntegerPosition> nestEntrancePosition;
     std::mt19937 rng;
     UniqueIdGenerator idGenerator;
+    std::unique_ptr<ThreadPool> threadPool;
+    std::uint64_t tick = 0;
+    std::uint64_t terrainRevision = 0;
+    std::uint64_t foodRevision = 0;
 
-    std::size_t tileIndex(int x, int y) const { return static_cast<std::size_t>(y) * width + x; }
+    World(unsigned int width, unsigned int height, unsigned int seed, std::size_t expectedAntCount,
+          const std::optional<std::filesystem::path>& chunkBackingFile, Uninitialized);
 
+    std::uint64_t tileBits(unsigned int x, unsigned int y) const;
+    void generateTile(Tile& tile) const;
     void updateAnts();
-    std::shared_ptr<Ant> createAnt(AntRole role, const IntegerPosition& pos);
+    void updateAntRange(std::size_t begin, std::size_t end);
+    void applyPendingPheromones();
 
 public:
     const unsigned int width;
     const unsigned int height;
+    // Terrain and initial food are a pure function of the seed and the tile
+    // position, generated chunk by chunk as the world is explored. With a
+    // backing file, tile chunks live in a file mapping instead of the heap.
     World(unsigned int width, unsigned int height, unsigned int initial_colony_size,
-          std::optional<unsigned int> seed = std::nullopt);
+          std::optional<unsigned int> seed = std::nullopt,
+          const std::optional<std::filesystem::path>& chunkBackingFile = std::nullopt);
 
     // World initialization
     void initialize(unsigned int initial_colony_size);
-    void generateTerrain();
     void placeNest(const IntegerPosition& pos);
     void placeFood(const IntegerPosition& pos, float amount);
+    // Terrain edits go through here so views can tell when to redraw it.
+    void setTerrain(const IntegerPosition& pos, TerrainType terrain);
+    // Terrain of an in-world tile without loading its chunk: what the
+    // generator will produce if the chunk has not been loaded yet.
+    TerrainType peekTerrain(unsigned int x, unsigned int y) const;
     
-    // Tile access
+    // Tile access. Looking up a tile loads its chunk.
     Tile* getTile(const IntegerPosition& pos);
     Tile* getTile(const FloatPosition& pos);
     Tile* getTile(int x, int y);
@@ -56,19 +94,49 @@ public:
     
     // World interactions
     void depositPheromone(const IntegerPosition& pos, PheromoneType type, float amount);
+    float getPheromone(const IntegerPosition& pos, PheromoneType type) const;
+    float getPheromone(int x, int y, PheromoneType type) const;
+    // Normalized food trail gradient at a tile (see GradientField).
+    Vector2D getTrailGradient(const IntegerPosition& pos) const;
+    // Next step from a tile on the cheapest path to the nest entrance (see
+    // FlowField); zero where the field does not cover the tile or is not
+    // built yet.
+    Vector2D getNestFlow(const IntegerPosition& pos) const;
+    const PheromoneField& getPheromones() const;
     void updatePheromones();
     void spawnFood(int count);
     void update();
     
     // Ant management
-    void addAnt(std::shared_ptr<Ant> ant, const IntegerPosition& pos);
+    std::optional<Ant> addAnt(AntRole role, const IntegerPosition& pos);
     IntegerPosition getNestEntrancePosition() const;
+
+    // Spatial queries over ant positions, current as of the end of the last
+    // tick (or initialize()).
+    const OccupancyGrid& getOccupancy() const;
+    std::size_t getAntCountAt(const IntegerPosition& pos) const;
     
+    // Parallelism. Results for a given seed are identical for every thread count.
+    void setThreadCount(unsigned int threadCount);
+    unsigned int getThreadCount() const;
+
     // World properties
     int getWidth() const;
     int getHeight() const;
-    const std::vector<std::shared_ptr<Ant>>& getAnts() const;
+    unsigned int getSeed() const;
+    // Number of update() calls since the world was created.
+    std::uint64_t getTick() const;
+    // Changes whenever setTerrain() changes a tile.
+    std::uint64_t getTerrainRevision() const;
+    // Changes whenever food is placed or cleared on a loaded tile. Chunks
+    // generated later bring their own food without changing it.
+    std::uint64_t getFoodRevision() const;
+    std::size_t getLoadedChunkCount() const;
+    AntStore& getAnts();
+    const AntStore& getAnts() const;
     
-    // Iteration over tiles
+    // Iteration over tiles. forEachTile() visits, and therefore loads, every
+    // tile of the world; forEachLoadedTile() only visits chunks already loaded.
     void forEachTile(std::function<void(Tile*)> callback);
+    void forEachLoadedTile(std::function<void(Tile*)> callback);
 };
\ No newline at end of file
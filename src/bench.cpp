@@ -0,0 +1,543 @@
+// bench.cpp - Microbenchmarks for the simulation's hot paths, reported as JSON
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Ant.h"
+#include "CommandLine.h"
+#include "FlowField.h"
+#include "GradientField.h"
+#include "MovementKernels.h"
+#include "MovementStrategy.h"
+#include "Position.h"
+#include "Random.h"
+#include "World.h"
+
+#ifdef ANTS_BENCH_VISUALIZER
+#include "RenderSnapshot.h"
+#include "Visualizer.h"
+#endif
+
+namespace {
+
+// Every world and every query set is derived from these, so two runs (or two
+// commits) benchmark exactly the same work.
+constexpr unsigned int kWorldSeed = 1;
+constexpr std::uint64_t kQuerySeed = 42;
+constexpr std::size_t kQueryCount = 4096;
+constexpr std::size_t kMinIterations = 5;
+constexpr std::size_t kMaxIterations = 1'000'000;
+constexpr float kTrailDepositAmount = 1.0f;
+
+struct Scenario {
+    unsigned int width;
+    unsigned int height;
+    unsigned int colonySize;
+    // Fraction of tiles that get food trail before each measured call.
+    float trailDensity;
+};
+
+struct BenchOptions {
+    std::string filter;
+    double minSeconds = 0.2;
+    bool quick = false;
+    std::optional<std::filesystem::path> outputPath;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string variant;
+    Scenario scenario;
+    std::size_t iterations;
+    std::size_t itemsPerIteration;
+    double meanNanoseconds;
+    double medianNanoseconds;
+    double minNanoseconds;
+};
+
+// Results are folded into this so the optimizer cannot drop the measured work.
+volatile std::uint64_t benchSink = 0;
+
+std::uint64_t bitsOf(float value) {
+    return std::bit_cast<std::uint32_t>(value);
+}
+
+std::vector<Scenario> scenariosFor(const BenchOptions& options) {
+    const std::vector<std::pair<unsigned int, unsigned int>> sizes = options.quick
+        ? std::vector<std::pair<unsigned int, unsigned int>>{ {50, 40}, {500, 400} }
+        : std::vector<std::pair<unsigned int, unsigned int>>{ {50, 40}, {500, 400}, {2000, 2000} };
+    const std::array<unsigned int, 2> colonySizes{ 100, 10000 };
+    const std::array<float, 2> trailDensities{ 0.0f, 0.05f };
+
+    std::vector<Scenario> scenarios;
+    for (const auto& [width, height] : sizes) {
+        for (const unsigned int colonySize : colonySizes) {
+            for (const float trailDensity : trailDensities) {
+                scenarios.push_back({ width, height, colonySize, trailDensity });
+            }
+        }
+    }
+    return scenarios;
+}
+
+// Deposits trail on trailDensity * width * height tiles picked from the
+// query stream; the same tiles every time for a given scenario.
+void depositTrail(World& world, const Scenario& scenario, PheromoneType type = PheromoneType::FoodTrail) {
+    const auto deposits = static_cast<std::size_t>(
+        scenario.trailDensity * static_cast<float>(scenario.width) * static_cast<float>(scenario.height));
+    CounterRng rng(kQuerySeed);
+    for (std::size_t i = 0; i < deposits; ++i) {
+        const int x = static_cast<int>(rng() % scenario.width);
+        const int y = static_cast<int>(rng() % scenario.height);
+        world.depositPheromone(IntegerPosition(x, y), type, kTrailDepositAmount);
+    }
+}
+
+std::unique_ptr<World> makeWorld(const Scenario& scenario) {
+    auto world = std::make_unique<World>(scenario.width, scenario.height, scenario.colonySize, kWorldSeed);
+    depositTrail(*world, scenario);
+    return world;
+}
+
+std::vector<IntegerPosition> makeQueries(const Scenario& scenario) {
+    CounterRng rng(kQuerySeed + 1);
+    std::vector<IntegerPosition> queries;
+    queries.reserve(kQueryCount);
+    for (std::size_t i = 0; i < kQueryCount; ++i) {
+        queries.emplace_back(static_cast<int>(rng() % scenario.width), static_cast<int>(rng() % scenario.height));
+    }
+    return queries;
+}
+
+/**
+ * @brief Times one call at a time until the minimum time is reached
+ *
+ * reset() runs before every call and is not timed. One untimed warm-up call
+ * comes first, so chunk loading and scratch buffers growing on first use are
+ * not counted.
+ */
+class BenchRunner {
+private:
+    const BenchOptions& options;
+    std::vector<BenchResult> results;
+
+public:
+    explicit BenchRunner(const BenchOptions& options) : options(options) {}
+
+    bool wants(std::string_view name) const {
+        return options.filter.empty() || name.find(options.filter) != std::string_view::npos;
+    }
+
+    template <typename Reset, typename Body>
+    void run(std::string name, std::string variant, const Scenario& scenario, std::size_t items,
+             Reset&& reset, Body&& body) {
+        using Clock = std::chrono::steady_clock;
+        reset();
+        body();
+
+        std::vector<double> samples;
+        double totalNanoseconds = 0.0;
+        while (samples.size() < kMaxIterations &&
+               (samples.size() < kMinIterations || totalNanoseconds < options.minSeconds * 1e9)) {
+            reset();
+            const auto start = Clock::now();
+            body();
+            const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            samples.push_back(elapsed.count());
+            totalNanoseconds += elapsed.count();
+        }
+
+        const double mean = totalNanoseconds / static_cast<double>(samples.size());
+        std::sort(samples.begin(), samples.end());
+        results.push_back({ std::move(name), std::move(variant), scenario, samples.size(), items, mean,
+                            samples[samples.size() / 2], samples.front() });
+        const BenchResult& result = results.back();
+        std::fprintf(stderr, "%-20s %-8s %5ux%-5u %6u ants trail %.2f: %12.0f ns median, %8.2f ns/item\n",
+                     result.name.c_str(), result.variant.c_str(), scenario.width, scenario.height,
+                     scenario.colonySize, scenario.trailDensity, result.medianNanoseconds,
+                     result.medianNanoseconds / static_cast<double>(std::max<std::size_t>(1, items)));
+    }
+
+    template <typename Body>
+    void run(std::string name, std::string variant, const Scenario& scenario, std::size_t items, Body&& body) {
+        run(std::move(name), std::move(variant), scenario, items, [] {}, std::forward<Body>(body));
+    }
+
+    const std::vector<BenchResult>& getResults() const { return results; }
+};
+
+void benchWorldConstruction(BenchRunner& runner, const Scenario& scenario) {
+    if (!runner.wants("world_construction")) return;
+    std::unique_ptr<World> built;
+    runner.run("world_construction", "", scenario, 1,
+               [&] { built.reset(); },
+               [&] {
+                   built = std::make_unique<World>(scenario.width, scenario.height, scenario.colonySize, kWorldSeed);
+                   benchSink = benchSink + built->getAnts().size();
+               });
+}
+
+void benchUpdatePheromones(BenchRunner& runner, const Scenario& scenario) {
+    if (!runner.wants("update_pheromones")) return;
+    // Depositing again before every call keeps the trail near a steady state
+    // instead of decaying to nothing over the run.
+    const auto world = makeWorld(scenario);
+    runner.run("update_pheromones", "", scenario, std::size_t{ scenario.width } * scenario.height,
+               [&] { depositTrail(*world, scenario); },
+               [&] { world->updatePheromones(); });
+
+    // The same trail laid in every channel: what a colony using all of them
+    // costs over one using only the food trail.
+    if (scenario.trailDensity == 0.0f) return;
+    const auto depositAll = [&] {
+        for (std::size_t type = 0; type < kPheromoneTypeCount; ++type) {
+            depositTrail(*world, scenario, static_cast<PheromoneType>(type));
+        }
+    };
+    depositAll();
+    runner.run("update_pheromones", "all_channels", scenario, std::size_t{ scenario.width } * scenario.height,
+               depositAll, [&] { world->updatePheromones(); });
+}
+
+void benchTrailGradient(BenchRunner& runner, const Scenario& scenario) {
+    if (!runner.wants("trail_gradient")) return;
+    // Depositing changes the field's revision, so every call rebuilds.
+    const auto world = makeWorld(scenario);
+    GradientField gradient(scenario.width, scenario.height);
+    runner.run("trail_gradient", "", scenario, std::size_t{ scenario.width } * scenario.height,
+               [&] { depositTrail(*world, scenario); },
+               [&] {
+                   gradient.update(world->getPheromones(), PheromoneType::FoodTrail);
+                   benchSink = benchSink + gradient.getBlockCount();
+               });
+}
+
+void benchNestFlow(BenchRunner& runner, const Scenario& scenario) {
+    // Terrain does not depend on the trail, so one density is enough.
+    if (!runner.wants("nest_flow") || scenario.trailDensity != 0.0f) return;
+    const auto world = makeWorld(scenario);
+    const IntegerPosition nest = world->getNestEntrancePosition();
+    const FlowField::TerrainLookup terrainAt = [&](unsigned int x, unsigned int y) {
+        return world->peekTerrain(x, y);
+    };
+    const std::size_t window = std::size_t{ std::min(scenario.width, 2 * FlowField::kRadius + 1) } *
+                               std::min(scenario.height, 2 * FlowField::kRadius + 1);
+
+    std::optional<FlowField> built;
+    runner.run("nest_flow", "build", scenario, window,
+               [&] { built.reset(); },
+               [&] {
+                   built.emplace(scenario.width, scenario.height);
+                   built->update(nest, terrainAt);
+                   benchSink = benchSink + built->getLastUpdatedTileCount();
+               });
+
+    // Rock appearing and disappearing a few tiles from the nest reroutes
+    // everything behind it.
+    FlowField field(scenario.width, scenario.height);
+    field.update(nest, terrainAt);
+    const IntegerPosition edited(nest.getIntX() + 3, nest.getIntY());
+    bool rock = false;
+    runner.run("nest_flow", "repair", scenario, window,
+               [&] {
+                   rock = !rock;
+                   world->setTerrain(edited, rock ? TerrainType::ROCK : TerrainType::SOIL);
+                   field.markChanged(edited);
+               },
+               [&] {
+                   field.update(nest, terrainAt);
+                   benchSink = benchSink + field.getLastUpdatedTileCount();
+               });
+}
+
+void benchAntUpdate(BenchRunner& runner, const Scenario& scenario) {
+    if (!runner.wants("ant_update")) return;
+    const auto world = makeWorld(scenario);
+    AntStore& ants = world->getAnts();
+    for (std::size_t r = 0; r < kAntRoleCount; ++r) {
+        const auto role = static_cast<AntRole>(r);
+        const auto [begin, end] = ants.roleRange(role);
+        if (begin == end) continue;
+        runner.run("ant_update", roleName(role), scenario, end - begin, [&, begin = begin, end = end] {
+            for (std::size_t i = begin; i < end; ++i) {
+                ants[i].update(*world);
+            }
+            benchSink = benchSink + bitsOf(ants.positions[begin].getX());
+        });
+    }
+}
+
+void benchDecide(BenchRunner& runner, const Scenario& scenario) {
+    const bool wantsDecide = runner.wants("decide_movement");
+    const bool wantsWander = runner.wants("decide_wander");
+    if (!wantsDecide && !wantsWander) return;
+    const auto world = makeWorld(scenario);
+    AntStore& ants = world->getAnts();
+    for (std::size_t r = 0; r < kAntRoleCount; ++r) {
+        const auto role = static_cast<AntRole>(r);
+        const auto [begin, end] = ants.roleRange(role);
+        if (begin == end) continue;
+        const std::size_t count = end - begin;
+
+        if (wantsDecide) {
+            // Strategies only see their inputs, so sensing once up front
+            // isolates the decision itself.
+            std::vector<SensoryInput> inputs;
+            inputs.reserve(count);
+            for (std::size_t i = begin; i < end; ++i) {
+                inputs.push_back(ants[i].sense(*world));
+            }
+            std::vector<CounterRng> rngs(ants.rngs.begin() + begin, ants.rngs.begin() + end);
+            std::vector<Vector2D> randomDirections(count);
+            runner.run("decide_movement", roleName(role), scenario, count, [&] {
+                // Same staging as World: random directions for the batch first.
+                movement_kernels::peekUnitVectors(rngs.data(), count, randomDirections.data());
+                std::uint64_t checksum = 0;
+                for (std::size_t i = 0; i < count; ++i) {
+                    RandomDirections random(rngs[i], &randomDirections[i]);
+                    const MovementDecision decision = decideMovement(role, inputs[i], random);
+                    checksum += bitsOf(decision.direction.x) + decision.actions.size();
+                }
+                benchSink = benchSink + checksum;
+            });
+        }
+
+        if (wantsWander && movement_kernels::isWanderRole(role)) {
+            std::vector<Vector2D> lastDirections(ants.lastDirections.begin() + begin, ants.lastDirections.begin() + end);
+            std::vector<CounterRng> rngs(ants.rngs.begin() + begin, ants.rngs.begin() + end);
+            std::vector<Vector2D> directions(count);
+            const float randomness = movement_kernels::wanderRandomnessFor(role);
+            runner.run("decide_wander", roleName(role), scenario, count, [&] {
+                movement_kernels::decideWander(lastDirections.data(), rngs.data(), count, randomness,
+                                               directions.data());
+                benchSink = benchSink + bitsOf(directions.back().x);
+            });
+        }
+    }
+}
+
+void benchTileQueries(BenchRunner& runner, const Scenario& scenario) {
+    const bool wantsAdjacent = runner.wants("adjacent_positions");
+    const bool wantsTile = runner.wants("get_tile");
+    if (!wantsAdjacent && !wantsTile) return;
+    const auto world = makeWorld(scenario);
+    const std::vector<IntegerPosition> queries = makeQueries(scenario);
+
+    if (wantsAdjacent) {
+        runner.run("adjacent_positions", "", scenario, queries.size(), [&] {
+            std::uint64_t checksum = 0;
+            for (const IntegerPosition& query : queries) {
+                checksum += world->getAdjacentPositions(query).size();
+            }
+            benchSink = benchSink + checksum;
+        });
+    }
+    if (wantsTile) {
+        runner.run("get_tile", "", scenario, queries.size(), [&] {
+            std::uint64_t checksum = 0;
+            for (const IntegerPosition& query : queries) {
+                checksum += static_cast<std::uint64_t>(world->getTile(query)->getTerrain());
+            }
+            benchSink = benchSink + checksum;
+        });
+    }
+}
+
+void benchPositionKernels(BenchRunner& runner, const Scenario& scenario) {
+    const bool wantsDistances = runner.wants("nest_distances");
+    const bool wantsNormalize = runner.wants("normalize_directions");
+    if (!wantsDistances && !wantsNormalize) return;
+    const auto world = makeWorld(scenario);
+    const AntStore& ants = world->getAnts();
+
+    if (wantsDistances) {
+        const FloatPosition nest(world->getNestEntrancePosition());
+        std::vector<float> distances(ants.size());
+        runner.run("nest_distances", "", scenario, ants.size(), [&] {
+            position_kernels::distances(ants.positions, nest, distances);
+            benchSink = benchSink + bitsOf(distances.back());
+        });
+    }
+    if (wantsNormalize) {
+        // Unnormalized inputs, restored before every call.
+        std::vector<Vector2D> source(ants.size());
+        for (std::size_t i = 0; i < ants.size(); ++i) {
+            source[i] = ants.positions[i].toVector2D();
+        }
+        std::vector<Vector2D> directions(source);
+        runner.run("normalize_directions", "", scenario, ants.size(),
+                   [&] { std::copy(source.begin(), source.end(), directions.begin()); },
+                   [&] {
+                       position_kernels::normalize(directions);
+                       benchSink = benchSink + bitsOf(directions.back().x);
+                   });
+    }
+}
+
+#ifdef ANTS_BENCH_VISUALIZER
+constexpr std::pair<unsigned int, unsigned int> kBenchScreenSize{ 1000, 800 };
+
+void benchDrawSnapshot(BenchRunner& runner, const Scenario& scenario) {
+    if (!runner.wants("draw_snapshot")) return;
+    const auto world = makeWorld(scenario);
+    RenderSnapshot snapshot;
+    snapshot.capture(*world);
+    // Needs a GL context (and the font from resources/); without one the
+    // render benchmark is skipped rather than failing the whole run.
+    std::unique_ptr<Visualizer> visualizer;
+    try {
+        visualizer = std::make_unique<Visualizer>(std::make_pair(scenario.width, scenario.height), kBenchScreenSize,
+                                                  Visualizer::Offscreen{});
+    } catch (const std::exception& error) {
+        std::cerr << "draw_snapshot skipped: " << error.what() << "\n";
+        return;
+    }
+    runner.run("draw_snapshot", "", scenario, snapshot.positions.size(), [&] {
+        visualizer->clear();
+        visualizer->drawSnapshot(*world, snapshot, 0.5f);
+        visualizer->display();
+    });
+}
+#endif
+
+void writeString(std::ostream& out, std::string_view value) {
+    // Names are plain identifiers; only quotes and backslashes need escaping.
+    out << '"';
+    for (const char c : value) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+void writeJson(std::ostream& out, const BenchOptions& options, const std::vector<BenchResult>& results) {
+    out << "{\n  \"context\": {\n    \"compiler\": ";
+#if defined(__VERSION__)
+    writeString(out, __VERSION__);
+#else
+    writeString(out, "unknown");
+#endif
+#ifdef NDEBUG
+    out << ",\n    \"assertions\": false";
+#else
+    out << ",\n    \"assertions\": true";
+#endif
+    out << ",\n    \"hardware_concurrency\": " << std::thread::hardware_concurrency()
+        << ",\n    \"world_seed\": " << kWorldSeed
+        << ",\n    \"query_seed\": " << kQuerySeed
+        << ",\n    \"min_time_seconds\": " << options.minSeconds
+        << "\n  },\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        writeString(out, result.name);
+        out << ", \"variant\": ";
+        writeString(out, result.variant);
+        out << ", \"width\": " << result.scenario.width
+            << ", \"height\": " << result.scenario.height
+            << ", \"colony\": " << result.scenario.colonySize
+            << ", \"trail_density\": " << result.scenario.trailDensity
+            << ", \"iterations\": " << result.iterations
+            << ", \"items_per_iteration\": " << result.itemsPerIteration
+            << ", \"mean_ns\": " << result.meanNanoseconds
+            << ", \"median_ns\": " << result.medianNanoseconds
+            << ", \"min_ns\": " << result.minNanoseconds
+            << ", \"ns_per_item\": "
+            << result.medianNanoseconds / static_cast<double>(std::max<std::size_t>(1, result.itemsPerIteration))
+            << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--filter SUBSTRING] [--min-time SECONDS] [--quick] [--output PATH]\n";
+}
+
+std::optional<BenchOptions> parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--help" || arg == "-h") return std::nullopt;
+        if (arg == "--quick") {
+            options.quick = true;
+            options.minSeconds = 0.05;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return std::nullopt;
+        }
+        if (arg == "--filter") {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time") {
+            const auto seconds = command_line::parseNumber<double>(argv[++i]);
+            if (!seconds) {
+                std::cerr << "Expected a number of seconds for --min-time\n";
+                return std::nullopt;
+            }
+            options.minSeconds = *seconds;
+        } else if (arg == "--output") {
+            options.outputPath = argv[++i];
+        } else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return std::nullopt;
+        }
+    }
+    if (options.minSeconds < 0.0) {
+        std::cerr << "--min-time must not be negative\n";
+        return std::nullopt;
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    BenchRunner runner(*options);
+    for (const Scenario& scenario : scenariosFor(*options)) {
+        benchWorldConstruction(runner, scenario);
+        benchUpdatePheromones(runner, scenario);
+        benchTrailGradient(runner, scenario);
+        benchNestFlow(runner, scenario);
+        benchAntUpdate(runner, scenario);
+        benchDecide(runner, scenario);
+        benchTileQueries(runner, scenario);
+        benchPositionKernels(runner, scenario);
+#ifdef ANTS_BENCH_VISUALIZER
+        benchDrawSnapshot(runner, scenario);
+#endif
+    }
+
+    if (options->outputPath) {
+        std::ofstream out(*options->outputPath);
+        writeJson(out, *options, runner.getResults());
+        if (!out) {
+            std::cerr << "Writing results failed: " << options->outputPath->string() << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cerr << "results written to " << options->outputPath->string() << "\n";
+    } else {
+        writeJson(std::cout, *options, runner.getResults());
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,327 @@
+// headless.cpp - Runs the simulation without a window, as fast as the CPU allows
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "Ant.h"
+#include "CommandLine.h"
+#include "Profiler.h"
+#include "Snapshot.h"
+#include "Trajectory.h"
+#include "World.h"
+
+namespace {
+
+struct HeadlessOptions {
+    unsigned int width = 50;
+    unsigned int height = 40;
+    unsigned int colonySize = 10;
+    std::optional<unsigned int> seed;
+    unsigned long ticks = 1000;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::optional<std::filesystem::path> chunkFile;
+    std::optional<std::filesystem::path> loadPath;
+    std::optional<std::filesystem::path> loadDeltaPath;
+    std::optional<std::filesystem::path> savePath;
+    std::optional<std::filesystem::path> recordPath;
+    std::optional<std::filesystem::path> profilePath;
+    unsigned long checkpointEvery = 0;
+    std::filesystem::path checkpointPrefix = "checkpoint";
+};
+
+/**
+ * @brief Writes a full snapshot, then deltas against it, every N ticks
+ *
+ * Deltas are relative to the last full snapshot, so they grow as the run
+ * drifts away from it; every kDeltasPerFullSnapshot checkpoints a new full
+ * snapshot starts over. Resume with --load PREFIX.full.snap --load-delta
+ * PREFIX.delta.snap (or just the full snapshot if no delta exists yet).
+ */
+class Checkpointer {
+private:
+    static constexpr unsigned int kDeltasPerFullSnapshot = 8;
+
+    std::filesystem::path fullPath;
+    std::filesystem::path deltaPath;
+    std::unique_ptr<snapshot::SnapshotView> base;
+    unsigned int deltasSinceFull = 0;
+
+public:
+    explicit Checkpointer(const std::filesystem::path& prefix)
+        : fullPath(prefix.string() + ".full.snap"), deltaPath(prefix.string() + ".delta.snap") {}
+
+    void write(const World& world) {
+        if (!base || deltasSinceFull == kDeltasPerFullSnapshot) {
+            WorldSnapshot::save(world, fullPath);
+            std::filesystem::remove(deltaPath);
+            base = std::make_unique<snapshot::SnapshotView>(fullPath);
+            deltasSinceFull = 0;
+        } else {
+            WorldSnapshot::saveDelta(world, *base, deltaPath);
+            ++deltasSinceFull;
+        }
+    }
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--width N] [--height N] [--colony N] [--seed N] [--ticks N] [--threads N]"
+                 " [--chunk-file PATH]\n"
+                 "       [--load SNAPSHOT [--load-delta DELTA]] [--save SNAPSHOT]"
+                 " [--checkpoint-every TICKS [--checkpoint-prefix PREFIX]]\n"
+                 "       [--record TRAJECTORY] [--profile REPORT]\n";
+}
+
+std::optional<HeadlessOptions> parseOptions(int argc, char** argv) {
+    HeadlessOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--help" || arg == "-h") return std::nullopt;
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return std::nullopt;
+        }
+        if (arg == "--chunk-file") {
+            options.chunkFile = argv[++i];
+            continue;
+        }
+        if (arg == "--load") {
+            options.loadPath = argv[++i];
+            continue;
+        }
+        if (arg == "--load-delta") {
+            options.loadDeltaPath = argv[++i];
+            continue;
+        }
+        if (arg == "--save") {
+            options.savePath = argv[++i];
+            continue;
+        }
+        if (arg == "--record") {
+            options.recordPath = argv[++i];
+            continue;
+        }
+        if (arg == "--profile") {
+            options.profilePath = argv[++i];
+            continue;
+        }
+        if (arg == "--checkpoint-prefix") {
+            options.checkpointPrefix = argv[++i];
+            continue;
+        }
+        const std::string_view text = argv[++i];
+        bool valid = true;
+        auto parseInto = [&](auto& target) {
+            const auto value = command_line::parseNumber<std::remove_reference_t<decltype(target)>>(text);
+            if (value) target = *value;
+            valid = value.has_value();
+        };
+        if (arg == "--width") {
+            parseInto(options.width);
+        } else if (arg == "--height") {
+            parseInto(options.height);
+        } else if (arg == "--colony") {
+            parseInto(options.colonySize);
+        } else if (arg == "--seed") {
+            options.seed = command_line::parseNumber<unsigned int>(text);
+            valid = options.seed.has_value();
+        } else if (arg == "--ticks") {
+            parseInto(options.ticks);
+        } else if (arg == "--threads") {
+            parseInto(options.threads);
+        } else if (arg == "--checkpoint-every") {
+            parseInto(options.checkpointEvery);
+        } else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return std::nullopt;
+        }
+        if (!valid) {
+            std::cerr << "Expected a non-negative whole number for " << arg << ", got '" << text << "'\n";
+            return std::nullopt;
+        }
+    }
+    if (options.width == 0 || options.height == 0 || options.colonySize == 0 || options.threads == 0) {
+        std::cerr << "World size, colony size and thread count must be positive\n";
+        return std::nullopt;
+    }
+    if (options.loadDeltaPath && !options.loadPath) {
+        std::cerr << "--load-delta needs --load\n";
+        return std::nullopt;
+    }
+    return options;
+}
+
+void printSummary(World& world) {
+    std::array<int, kAntRoleCount> roleCounts{};
+    float carriedLoad = 0.0f;
+    for (Ant ant : world.getAnts()) {
+        ++roleCounts[static_cast<std::size_t>(ant.getRole())];
+        carriedLoad += ant.getCurrentLoad();
+    }
+
+    // Only explored chunks and active pheromone blocks are visited, so this
+    // stays cheap on huge worlds. Food on unexplored chunks is not counted.
+    int foodTiles = 0;
+    double foodAmount = 0.0;
+    world.forEachLoadedTile([&](Tile* tile) {
+        if (tile->getHasFood()) {
+            ++foodTiles;
+            foodAmount += tile->getFoodAmount();
+        }
+    });
+
+    const PheromoneField& pheromones = world.getPheromones();
+    std::vector<std::uint32_t> trailBlocks = pheromones.getActiveBlocks(PheromoneType::FoodTrail);
+    std::sort(trailBlocks.begin(), trailBlocks.end());
+    int trailTiles = 0;
+    double trailTotal = 0.0;
+    for (const std::uint32_t block : trailBlocks) {
+        const float* values = pheromones.block(PheromoneType::FoodTrail, block);
+        for (std::size_t i = 0; i < PheromoneField::kBlockArea; ++i) {
+            if (values[i] > 0.0f) {
+                ++trailTiles;
+                trailTotal += values[i];
+            }
+        }
+    }
+
+    std::cout << "ants: " << world.getAnts().size() << " (";
+    for (std::size_t r = 0; r < roleCounts.size(); ++r) {
+        if (r > 0) std::cout << ", ";
+        std::cout << roleName(static_cast<AntRole>(r)) << " " << roleCounts[r];
+    }
+    std::cout << ")\n"
+              << "ants at nest entrance: " << world.getAntCountAt(world.getNestEntrancePosition()) << "\n"
+              << "carried load: " << carriedLoad << "\n"
+              << "loaded chunks: " << world.getLoadedChunkCount() << "\n"
+              << "food: " << foodAmount << " on " << foodTiles << " explored tiles\n"
+              << "food trail: " << trailTotal << " on " << trailTiles << " tiles\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const auto setupStart = std::chrono::steady_clock::now();
+    std::unique_ptr<World> loadedWorld;
+    try {
+        if (options->loadPath) {
+            loadedWorld = WorldSnapshot::load(*options->loadPath, options->loadDeltaPath, options->chunkFile);
+        } else {
+            loadedWorld = std::make_unique<World>(options->width, options->height, options->colonySize,
+                                                  options->seed, options->chunkFile);
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    World& world = *loadedWorld;
+    world.setThreadCount(options->threads);
+    std::optional<Checkpointer> checkpointer;
+    if (options->checkpointEvery > 0) {
+        checkpointer.emplace(options->checkpointPrefix);
+    }
+    std::unique_ptr<TrajectoryRecorder> recorder;
+    if (options->recordPath) {
+        try {
+            recorder = std::make_unique<TrajectoryRecorder>(*options->recordPath, world);
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    profiler::setEnabled(options->profilePath.has_value());
+    const auto simulationStart = std::chrono::steady_clock::now();
+
+    // The first tick may still grow scratch buffers. After that, the only
+    // allocations expected are lazy growth: chunks, pheromone blocks and
+    // table pages for parts of the world ants reach for the first time.
+    // Those are reported on their own; anything else in a later tick is a
+    // regression. Checkpoints are written between ticks and not counted.
+    std::size_t steadyStateAllocations = 0;
+    std::size_t lazyGrowthAllocations = 0;
+    for (unsigned long tick = 0; tick < options->ticks; ++tick) {
+        const std::size_t allocationsBefore = allocation_counter::getAllocationCount();
+        const std::size_t lazyGrowthBefore = allocation_counter::getLazyGrowthCount();
+        world.update();
+        if (recorder) {
+            recorder->record(world);
+        }
+        if (tick > 0) {
+            const std::size_t lazyGrowth = allocation_counter::getLazyGrowthCount() - lazyGrowthBefore;
+            steadyStateAllocations += allocation_counter::getAllocationCount() - allocationsBefore - lazyGrowth;
+            lazyGrowthAllocations += lazyGrowth;
+        }
+        if (checkpointer && world.getTick() % options->checkpointEvery == 0) {
+            try {
+                checkpointer->write(world);
+            } catch (const std::exception& error) {
+                std::cerr << "Checkpoint failed: " << error.what() << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    const auto simulationEnd = std::chrono::steady_clock::now();
+    if (recorder) {
+        try {
+            recorder->finish();
+        } catch (const std::exception& error) {
+            std::cerr << "Recording failed: " << error.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    const std::chrono::duration<double> setupTime = simulationStart - setupStart;
+    const std::chrono::duration<double> simulationTime = simulationEnd - simulationStart;
+
+    std::cout << "world: " << world.width << "x" << world.height
+              << " (seed " << world.getSeed() << ", " << world.getThreadCount() << " threads)\n"
+              << "setup: " << setupTime.count() << " s\n"
+              << "ticks: " << options->ticks << " in " << simulationTime.count() << " s\n"
+              << "ticks/sec: "
+              << (simulationTime.count() > 0.0 ? options->ticks / simulationTime.count() : 0.0) << "\n"
+              << "steady-state allocations: " << steadyStateAllocations << "\n"
+              << "lazy growth allocations: " << lazyGrowthAllocations << "\n";
+    printSummary(world);
+    if (recorder) {
+        std::cout << "recorded " << recorder->getBytesWritten() << " bytes to " << options->recordPath->string() << "\n";
+    }
+    if (options->profilePath) {
+        std::ofstream report(*options->profilePath);
+        profiler::writeReport(report, profiler::collect());
+        if (!report) {
+            std::cerr << "Writing profile report failed: " << options->profilePath->string() << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "profile written to " << options->profilePath->string() << "\n";
+    }
+    if (options->savePath) {
+        try {
+            WorldSnapshot::save(world, *options->savePath);
+        } catch (const std::exception& error) {
+            std::cerr << "Saving snapshot failed: " << error.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "saved tick " << world.getTick() << " to " << options->savePath->string() << "\n";
+    }
+    return EXIT_SUCCESS;
+}
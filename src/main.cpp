@@ -1,7 +1,22 @@
 // main.cpp - Ant Colony Simulator with main simulation loop
+#include "Profiler.h"
+#include "RenderSnapshot.h"
+#include "SimulationThread.h"
+#include "Snapshot.h"
 #include "Timer.h"
+#include "TrajectoryPlayer.h"
 #include "Visualizer.h"
 #include "World.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 // Simulation parameters
@@ -10,31 +25,162 @@ const std::pair<unsigned int, unsigned int> worldSize = {50, 40};
 const std::pair<unsigned int, unsigned int> screenSize = {800, 600};
 const float simulationStepsPerSecond = 0.2;
 
-int main() {
+namespace {
+
+/**
+ * Runs the simulation live. R runs in real time, Up/Down double or halve the
+ * speed and F runs as many ticks as fit in each frame.
+ */
+int runSimulation(RunMode initialMode, float initialMultiplier) {
     Timer timer(simulationStepsPerSecond);
     World world(worldSize.first, worldSize.second, initialColonySize);
     world.initialize(initialColonySize);
     Visualizer visualizer(worldSize, screenSize);
-    bool running = true;
-    
-    while (running && visualizer.isOpen()) {
+    // Ticks run on their own thread from here on; frames only read the
+    // snapshots it publishes (and the static terrain).
+    SimulationThread simulation(world, simulationStepsPerSecond);
+    simulation.setRunMode(initialMode, initialMultiplier);
+    visualizer.setKeyHandler([&simulation](sf::Keyboard::Key key) {
+        const float speed = simulation.getRunMode() == RunMode::Multiplier ? simulation.getMultiplier() : 1.0f;
+        switch (key) {
+            case sf::Keyboard::Key::R:    simulation.setRunMode(RunMode::RealTime); break;
+            case sf::Keyboard::Key::F:    simulation.setRunMode(RunMode::AsFastAsPossible); break;
+            case sf::Keyboard::Key::Up:   simulation.setRunMode(RunMode::Multiplier, std::min(speed * 2.0f, 1.0e6f)); break;
+            case sf::Keyboard::Key::Down: simulation.setRunMode(RunMode::Multiplier, std::max(speed / 2.0f, 1.0f / 64)); break;
+            default: break;
+        }
+    });
+    std::uint64_t lastDrawnTick = 0;
+
+    timer.getFrameDeltaTime(); // starts the frame clock
+    while (visualizer.isOpen()) {
         visualizer.clear();
         visualizer.processEvents();
         // Get frame time for FPS calculation
         float frameTime = timer.getFrameDeltaTime();
-        
-        // Run simulation steps as needed
-        int stepsToRun = timer.getSimulationStepsToRun();
-        for (int i = 0; i < stepsToRun; i++) {
-            world.update();
-        }
-        float accumulatedTime = timer.getAccumulatedTime();
-        float interpolation = accumulatedTime / timer.getSimulationStepSize();
-        visualizer.drawWorld(world, interpolation);
+
+        const RenderSnapshot& snapshot = simulation.acquireSnapshot();
+        const float interpolation = snapshot.interpolationAt(std::chrono::steady_clock::now());
+        visualizer.drawSnapshot(world, snapshot, interpolation);
         // Display simulation stats
         float fps = 1.0f / frameTime;
-        visualizer.displayStats(fps, stepsToRun);
+        visualizer.displayStats(fps, static_cast<int>(snapshot.tick - lastDrawnTick), snapshot.droppedSeconds);
+        lastDrawnTick = snapshot.tick;
+        visualizer.displayProfile();
+        visualizer.display();
+    }
+    return 0;
+}
+
+/**
+ * Plays a recorded trajectory over the terrain of its world: from a snapshot
+ * if one is given, otherwise regenerated from the seed in the recording.
+ *
+ * Space pauses, Left/Right jump five seconds of playback, Up/Down double or
+ * halve the speed, Comma/Period step one tick, Home/End jump to either end
+ * and clicking or dragging on the progress bar scrubs.
+ */
+int runReplay(const std::filesystem::path& trajectoryPath, const std::optional<std::filesystem::path>& snapshotPath) {
+    TrajectoryPlayer player(trajectoryPath);
+    const auto& header = player.getHeader();
+    const std::unique_ptr<World> world = snapshotPath
+        ? WorldSnapshot::load(*snapshotPath)
+        : std::make_unique<World>(header.width, header.height, 1, header.seed);
+    // The world does not tick during a replay: food and trail are captured once.
+    RenderSnapshot scene;
+    scene.capture(*world);
+
+    Timer timer;
+    Visualizer visualizer({header.width, header.height}, screenSize);
+    visualizer.setKeyHandler([&player](sf::Keyboard::Key key) {
+        switch (key) {
+            case sf::Keyboard::Key::Space:  player.setPlaying(!player.isPlaying()); break;
+            case sf::Keyboard::Key::Right:  player.seek(player.getPosition() + 5.0 * player.getSpeed()); break;
+            case sf::Keyboard::Key::Left:   player.seek(player.getPosition() - 5.0 * player.getSpeed()); break;
+            case sf::Keyboard::Key::Up:     player.setSpeed(std::min(player.getSpeed() * 2.0, 1.0e6)); break;
+            case sf::Keyboard::Key::Down:   player.setSpeed(std::max(player.getSpeed() / 2.0, 0.25)); break;
+            case sf::Keyboard::Key::Period: player.setPlaying(false); player.seek(player.getPosition() + 1.0); break;
+            case sf::Keyboard::Key::Comma:  player.setPlaying(false); player.seek(player.getPosition() - 1.0); break;
+            case sf::Keyboard::Key::Home:   player.seek(static_cast<double>(player.getFirstTick())); break;
+            case sf::Keyboard::Key::End:    player.seek(static_cast<double>(player.getEndTick())); break;
+            default: break;
+        }
+    });
+    visualizer.setScrubHandler([&player](float fraction) {
+        const double span = static_cast<double>(player.getEndTick() - player.getFirstTick());
+        player.seek(static_cast<double>(player.getFirstTick()) + fraction * span);
+    });
+
+    timer.getFrameDeltaTime(); // starts the frame clock
+    while (visualizer.isOpen()) {
+        visualizer.clear();
+        visualizer.processEvents();
+        const float frameTime = timer.getFrameDeltaTime();
+        player.advance(frameTime);
+        visualizer.drawReplay(*world, scene, player.currentFrames());
+        visualizer.displayStats(1.0f / frameTime, 0);
+        visualizer.displayReplayStatus(player);
+        visualizer.displayProfile();
         visualizer.display();
     }
     return 0;
-}
\ No newline at end of file
+}
+
+void writeProfile(const std::filesystem::path& path) {
+    std::ofstream report(path);
+    profiler::writeReport(report, profiler::collect());
+    if (!report) {
+        std::cerr << "Writing profile report failed: " << path.string() << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::optional<std::filesystem::path> replayPath;
+    std::optional<std::filesystem::path> snapshotPath;
+    std::optional<std::filesystem::path> profilePath;
+    RunMode runMode = RunMode::RealTime;
+    float speed = 1.0f;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (arg == "--fast") {
+            runMode = RunMode::AsFastAsPossible;
+        } else if (arg == "--speed" && i + 1 < argc) {
+            speed = std::strtof(argv[++i], nullptr);
+            if (!(speed > 0.0f)) {
+                std::cerr << "--speed needs a positive multiplier\n";
+                return EXIT_FAILURE;
+            }
+            runMode = RunMode::Multiplier;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--speed MULTIPLIER | --fast] [--replay TRAJECTORY [--snapshot SNAPSHOT]]"
+                         " [--profile REPORT]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Cheap enough to leave on for the on-screen phase timings.
+    profiler::setEnabled(true);
+    int result = EXIT_SUCCESS;
+    if (!replayPath) {
+        result = runSimulation(runMode, speed);
+    } else {
+        try {
+            result = runReplay(*replayPath, snapshotPath);
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << "\n";
+            result = EXIT_FAILURE;
+        }
+    }
+    if (profilePath) {
+        writeProfile(*profilePath);
+    }
+    return result;
+}
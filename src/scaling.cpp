@@ -0,0 +1,332 @@
+// scaling.cpp - Runs full ticks over a matrix of colony sizes, world sizes and
+// thread counts, and reports throughput, memory and allocations as CSV
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "AllocationCounter.h"
+#include "CommandLine.h"
+#include "PheromoneField.h"
+#include "Profiler.h"
+#include "World.h"
+
+namespace {
+
+struct WorldSize {
+    unsigned int width;
+    unsigned int height;
+};
+
+struct ScalingOptions {
+    std::vector<unsigned long> colonySizes{ 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000 };
+    std::vector<WorldSize> worldSizes{ {50, 40}, {500, 400}, {2000, 2000}, {20000, 20000} };
+    std::vector<unsigned long> threadCounts;
+    unsigned int seed = 1;
+    unsigned long maxTicks = 100;
+    double maxSeconds = 5.0;
+    std::optional<std::filesystem::path> outputPath;
+};
+
+// Filled in by the child process running one case and sent to the parent
+// through a pipe, hence plain data only.
+struct CaseResult {
+    std::uint64_t ticks = 0;
+    double setupSeconds = 0.0;
+    double tickSeconds = 0.0;
+    std::uint64_t tickNanoseconds = 0;
+    std::uint64_t diffusionNanoseconds = 0;
+    std::uint64_t diffusedTiles = 0;
+    std::uint64_t setupAllocations = 0;
+    std::uint64_t tickAllocations = 0;
+};
+
+// 1, 2, 4, ... up to and including the hardware thread count.
+std::vector<unsigned long> defaultThreadCounts() {
+    const unsigned long hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned long> counts;
+    for (unsigned long threads = 1; threads < hardwareThreads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(hardwareThreads);
+    return counts;
+}
+
+/**
+ * @brief Runs one case; called in the child process
+ *
+ * The first tick grows scratch buffers and is not measured. Ticks then run
+ * until maxTicks or maxSeconds is reached, whichever comes first. The split
+ * between ant updates and diffusion comes from the profiler, whose timers
+ * cost a few nanoseconds per ant.
+ */
+CaseResult runCase(const ScalingOptions& options, WorldSize size, unsigned long colonySize, unsigned long threads) {
+    using Clock = std::chrono::steady_clock;
+    CaseResult result;
+
+    const std::size_t setupAllocationsBefore = allocation_counter::getAllocationCount();
+    const auto setupStart = Clock::now();
+    World world(size.width, size.height, static_cast<unsigned int>(colonySize), options.seed);
+    world.setThreadCount(static_cast<unsigned int>(threads));
+    world.update();
+    result.setupSeconds = std::chrono::duration<double>(Clock::now() - setupStart).count();
+    result.setupAllocations = allocation_counter::getAllocationCount() - setupAllocationsBefore;
+
+    profiler::setEnabled(true);
+    const std::size_t tickAllocationsBefore = allocation_counter::getAllocationCount();
+    const auto tickStart = Clock::now();
+    do {
+        world.update();
+        result.diffusedTiles += world.getPheromones().getLastDiffusedTileCount();
+        ++result.ticks;
+        result.tickSeconds = std::chrono::duration<double>(Clock::now() - tickStart).count();
+    } while (result.ticks < options.maxTicks && result.tickSeconds < options.maxSeconds);
+    result.tickAllocations = allocation_counter::getAllocationCount() - tickAllocationsBefore;
+    profiler::setEnabled(false);
+
+    const profiler::PhaseHistograms phases = profiler::collect();
+    result.tickNanoseconds = phases[static_cast<std::size_t>(ProfilePhase::Tick)].totalNanoseconds;
+    result.diffusionNanoseconds = phases[static_cast<std::size_t>(ProfilePhase::PheromoneDiffusion)].totalNanoseconds;
+    return result;
+}
+
+bool writeAll(int fd, const void* data, std::size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t written = ::write(fd, bytes, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, std::size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        const ssize_t got = ::read(fd, bytes, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        bytes += got;
+        size -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+/**
+ * @brief Runs one case in a forked child and writes its CSV row
+ *
+ * A fresh process per case makes the peak RSS (from wait4) belong to that
+ * case alone, and a case that runs out of memory is reported as failed
+ * instead of ending the sweep.
+ */
+void runCaseInChild(std::ostream& out, const ScalingOptions& options, WorldSize size, unsigned long colonySize,
+                    unsigned long threads) {
+    // Written together with the results, so a failing child's stderr cannot
+    // end up in the middle of a row.
+    const std::string key = std::to_string(size.width) + "," + std::to_string(size.height) + "," +
+                            std::to_string(colonySize) + "," + std::to_string(threads) + ",";
+
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        out << key << ",,,,,,,,,failed (pipe)\n" << std::flush;
+        return;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(fds[0]);
+        const CaseResult result = runCase(options, size, colonySize, threads);
+        const bool sent = writeAll(fds[1], &result, sizeof(result));
+        ::_exit(sent ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    ::close(fds[1]);
+    if (pid < 0) {
+        ::close(fds[0]);
+        out << key << ",,,,,,,,,failed (fork)\n" << std::flush;
+        return;
+    }
+
+    CaseResult result;
+    const bool received = readAll(fds[0], &result, sizeof(result));
+    ::close(fds[0]);
+    int status = 0;
+    rusage usage{};
+    while (::wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {}
+
+    if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        std::string reason = "failed";
+        if (WIFSIGNALED(status)) {
+            reason += " (signal " + std::to_string(WTERMSIG(status)) + ")";
+        }
+        out << key << ",,,,,," << usage.ru_maxrss << ",,," << reason << "\n" << std::flush;
+        return;
+    }
+
+    const double ticksPerSecond = result.tickSeconds > 0.0 ? result.ticks / result.tickSeconds : 0.0;
+    const double antNanoseconds = static_cast<double>(result.tickNanoseconds - std::min(result.tickNanoseconds,
+                                                                                     result.diffusionNanoseconds));
+    const double nsPerAntUpdate = antNanoseconds / (static_cast<double>(result.ticks) * colonySize);
+    const auto tilesDiffused = static_cast<double>(result.diffusedTiles);
+
+    char row[256];
+    int length = std::snprintf(row, sizeof(row), "%llu,%.3f,%.2f,%.3f,", static_cast<unsigned long long>(result.ticks),
+                               result.setupSeconds, ticksPerSecond, nsPerAntUpdate);
+    // Left empty when no pheromone was active, rather than a misleading 0.
+    if (tilesDiffused > 0.0) {
+        length += std::snprintf(row + length, sizeof(row) - length, "%.3f", result.diffusionNanoseconds / tilesDiffused);
+    }
+    std::snprintf(row + length, sizeof(row) - length, ",");
+    // ru_maxrss is in kilobytes on Linux.
+    out << key << row << static_cast<unsigned long long>(tilesDiffused / static_cast<double>(result.ticks)) << ","
+        << usage.ru_maxrss << "," << result.setupAllocations << ","
+        << static_cast<double>(result.tickAllocations) / static_cast<double>(result.ticks) << ",ok\n"
+        << std::flush;
+}
+
+template <typename T, typename Parse>
+std::optional<std::vector<T>> parseList(std::string_view text, Parse parse) {
+    std::vector<T> values;
+    while (!text.empty()) {
+        const std::size_t comma = text.find(',');
+        const auto value = parse(text.substr(0, comma));
+        if (!value) return std::nullopt;
+        values.push_back(*value);
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+    }
+    if (values.empty()) return std::nullopt;
+    return values;
+}
+
+std::optional<unsigned long> parseCount(std::string_view text) {
+    const auto parsed = command_line::parseNumber<unsigned long>(text);
+    if (!parsed || *parsed == 0) return std::nullopt;
+    return parsed;
+}
+
+std::optional<WorldSize> parseWorldSize(std::string_view text) {
+    const std::size_t x = text.find('x');
+    if (x == std::string_view::npos) return std::nullopt;
+    const auto width = parseCount(text.substr(0, x));
+    const auto height = parseCount(text.substr(x + 1));
+    if (!width || !height) return std::nullopt;
+    return WorldSize{ static_cast<unsigned int>(*width), static_cast<unsigned int>(*height) };
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--ants N,N,...] [--sizes WxH,WxH,...] [--threads N,N,...] [--seed N]\n"
+                 "       [--ticks N] [--seconds S] [--output CSV]\n";
+}
+
+std::optional<ScalingOptions> parseOptions(int argc, char** argv) {
+    ScalingOptions options;
+    options.threadCounts = defaultThreadCounts();
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--help" || arg == "-h") return std::nullopt;
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return std::nullopt;
+        }
+        const std::string_view value = argv[++i];
+        if (arg == "--ants" || arg == "--threads") {
+            auto counts = parseList<unsigned long>(value, parseCount);
+            if (!counts) {
+                std::cerr << "Expected positive numbers for " << arg << "\n";
+                return std::nullopt;
+            }
+            (arg == "--ants" ? options.colonySizes : options.threadCounts) = std::move(*counts);
+        } else if (arg == "--sizes") {
+            auto sizes = parseList<WorldSize>(value, parseWorldSize);
+            if (!sizes) {
+                std::cerr << "Expected WIDTHxHEIGHT pairs for --sizes\n";
+                return std::nullopt;
+            }
+            options.worldSizes = std::move(*sizes);
+        } else if (arg == "--seed") {
+            const auto seed = command_line::parseNumber<unsigned int>(value);
+            if (!seed) {
+                std::cerr << "Expected a non-negative whole number for --seed\n";
+                return std::nullopt;
+            }
+            options.seed = *seed;
+        } else if (arg == "--ticks") {
+            const auto ticks = parseCount(value);
+            if (!ticks) {
+                std::cerr << "--ticks must be a positive whole number\n";
+                return std::nullopt;
+            }
+            options.maxTicks = *ticks;
+        } else if (arg == "--seconds") {
+            const auto seconds = command_line::parseNumber<double>(value);
+            if (!seconds || *seconds <= 0.0) {
+                std::cerr << "--seconds must be positive\n";
+                return std::nullopt;
+            }
+            options.maxSeconds = *seconds;
+        } else if (arg == "--output") {
+            options.outputPath = argv[i];
+        } else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return std::nullopt;
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream file;
+    if (options->outputPath) {
+        file.open(*options->outputPath);
+        if (!file) {
+            std::cerr << "Cannot write " << options->outputPath->string() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream& out = options->outputPath ? file : std::cout;
+
+    out << "width,height,ants,threads,ticks,setup_seconds,ticks_per_sec,ns_per_ant_update,ns_per_tile_diffused,"
+           "tiles_diffused_per_tick,peak_rss_kb,setup_allocations,allocations_per_tick,status\n";
+    for (const WorldSize& size : options->worldSizes) {
+        for (const unsigned long colonySize : options->colonySizes) {
+            for (const unsigned long threads : options->threadCounts) {
+                runCaseInChild(out, *options, size, colonySize, threads);
+            }
+        }
+    }
+    if (options->outputPath) {
+        if (!file) {
+            std::cerr << "Writing results failed: " << options->outputPath->string() << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cerr << "results written to " << options->outputPath->string() << "\n";
+    }
+    return EXIT_SUCCESS;
+}